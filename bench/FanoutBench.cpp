@@ -0,0 +1,263 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+/*
+ * Fan-out load generator. Opens N websocket clients against the service, subscribes them all to one
+ * symbol and publishes ticks into its Redis stream at a fixed rate. Each tick carries its publish time,
+ * so clients can measure end-to-end delivery latency (publisher and clients share the host clock).
+ *
+ *   FanoutBench --connections 50000 --rate 100 --duration 30 --threads 4 --source-ips 4
+ *
+ * A single source address runs out of ephemeral ports around 28k connections, so clients are spread
+ * over 127.0.0.1 .. 127.0.0.<source-ips>. Raise `ulimit -n` on both sides before going past ~1k.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <hiredis/hiredis.h>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+using tcp = asio::ip::tcp;
+
+namespace {
+
+struct Options {
+    std::string host = "127.0.0.1";
+    unsigned short port = 8000;
+    std::string redisHost = "127.0.0.1";
+    int redisPort = 6379;
+    std::string symbol = "BENCH";
+    size_t connections = 10'000;
+    int rate = 100;          // ticks per second
+    int duration = 30;       // seconds of publishing
+    int threads = 1;
+    int sourceIps = 1;
+};
+
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 10 microsecond buckets up to 1s, anything slower lands in the last bucket
+struct Stats {
+    static constexpr size_t bucketCount = 100'000;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(bucketCount, 0);
+    uint64_t messages = 0;
+    uint64_t connected = 0;
+    uint64_t errors = 0;
+
+    void record(int64_t latencyNanos) {
+        size_t bucket = std::min<size_t>(std::max<int64_t>(latencyNanos, 0) / 10'000, bucketCount - 1);
+        ++buckets[bucket];
+        ++messages;
+    }
+
+    void merge(const Stats& other) {
+        for (size_t i = 0; i < bucketCount; ++i) buckets[i] += other.buckets[i];
+        messages += other.messages;
+        connected += other.connected;
+        errors += other.errors;
+    }
+
+    double percentileMicros(double p) const {
+        uint64_t target = static_cast<uint64_t>(p * messages), seen = 0;
+        for (size_t i = 0; i < bucketCount; ++i) {
+            seen += buckets[i];
+            if (seen > target) return i * 10.0;
+        }
+        return bucketCount * 10.0;
+    }
+};
+
+class BenchClient : public std::enable_shared_from_this<BenchClient> {
+public:
+    BenchClient(asio::io_context& ioc, Stats& stats, const Options& opts, size_t index)
+            : ws_(ioc), stats_(stats), opts_(opts), index_(index) {}
+
+    void start(const tcp::endpoint& server, const asio::ip::address_v4& source) {
+        auto& socket = ws_.next_layer();
+        boost::system::error_code ec;
+        socket.open(tcp::v4(), ec);
+        socket.bind(tcp::endpoint(source, 0), ec);
+        if (ec) {
+            ++stats_.errors;
+            return;
+        }
+        socket.async_connect(server, [self = shared_from_this()](boost::system::error_code ec) {
+            if (ec) {
+                ++self->stats_.errors;
+                return;
+            }
+            self->ws_.async_handshake(self->opts_.host, "/cpp/ws", [self](boost::system::error_code ec) {
+                if (ec) {
+                    ++self->stats_.errors;
+                    return;
+                }
+                self->subscribe();
+            });
+        });
+    }
+
+private:
+    websocket::stream<tcp::socket> ws_;
+    beast::flat_buffer buffer_;
+    std::string request_;
+    const std::string pingRequest_ = R"({"action":"ping","userId":"bench"})";
+    bool pinging_ = false;
+    Stats& stats_;
+    const Options& opts_;
+    size_t index_;
+
+    void subscribe() {
+        request_ = R"({"action":"subscribe","value":[")" + opts_.symbol + R"("],"userId":"bench-)" + std::to_string(index_) + R"("})";
+        ws_.async_write(asio::buffer(request_), [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+            if (ec) {
+                ++self->stats_.errors;
+                return;
+            }
+            ++self->stats_.connected;
+            self->read();
+        });
+    }
+
+    void read() {
+        ws_.async_read(buffer_, [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+            if (ec) {
+                ++self->stats_.errors;
+                return;
+            }
+            self->onMessage();
+            self->buffer_.consume(self->buffer_.size());
+            self->read();
+        });
+    }
+
+    void ping() {
+        if (pinging_) {
+            return;
+        }
+        pinging_ = true;
+        ws_.async_write(asio::buffer(pingRequest_), [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+            self->pinging_ = false;
+            if (ec) {
+                ++self->stats_.errors;
+            }
+        });
+    }
+
+    void onMessage() {
+        // Cheap scan instead of a JSON parse, the client must not become the bottleneck
+        auto data = static_cast<const char*>(buffer_.data().data());
+        std::string_view msg(data, buffer_.size());
+        auto pos = msg.find(R"("ts":)");
+        if (pos == std::string_view::npos) {
+            // the server drops clients that stay silent, so heartbeats are answered like a real client would
+            if (msg.find(R"("heartbeat")") != std::string_view::npos) {
+                ping();
+            }
+            return;  // heartbeat or error reply
+        }
+        int64_t sent = std::strtoll(data + pos + 5, nullptr, 10);
+        stats_.record(nowNanos() - sent);
+    }
+};
+
+void publish(const Options& opts, std::atomic<bool>& running) {
+    redisContext* ctx = redisConnect(opts.redisHost.c_str(), opts.redisPort);
+    if (ctx == nullptr || ctx->err) {
+        std::cerr << "Publisher cannot connect to Redis\n";
+        if (ctx) redisFree(ctx);
+        return;
+    }
+
+    auto interval = std::chrono::nanoseconds(1'000'000'000 / std::max(opts.rate, 1));
+    auto next = std::chrono::steady_clock::now();
+    while (running.load()) {
+        std::string payload = R"({"ts":)" + std::to_string(nowNanos()) + R"(,"ltp":100.5,"volume":1200})";
+        auto* reply = (redisReply*) redisCommand(ctx, "XADD %s MAXLEN ~ 10000 * payload %s",
+                                                 opts.symbol.c_str(), payload.c_str());
+        if (reply) freeReplyObject(reply);
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+    redisFree(ctx);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], val = argv[i + 1];
+        if (arg == "--host") opts.host = val;
+        else if (arg == "--port") opts.port = static_cast<unsigned short>(std::stoi(val));
+        else if (arg == "--redis-host") opts.redisHost = val;
+        else if (arg == "--redis-port") opts.redisPort = std::stoi(val);
+        else if (arg == "--symbol") opts.symbol = val;
+        else if (arg == "--connections") opts.connections = std::stoul(val);
+        else if (arg == "--rate") opts.rate = std::stoi(val);
+        else if (arg == "--duration") opts.duration = std::stoi(val);
+        else if (arg == "--threads") opts.threads = std::max(1, std::stoi(val));
+        else if (arg == "--source-ips") opts.sourceIps = std::max(1, std::stoi(val));
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    tcp::endpoint server(asio::ip::make_address(opts.host), opts.port);
+
+    std::vector<std::unique_ptr<asio::io_context>> contexts;
+    std::vector<Stats> stats(opts.threads);
+    for (int t = 0; t < opts.threads; ++t) {
+        contexts.push_back(std::make_unique<asio::io_context>(1));
+    }
+
+    for (size_t i = 0; i < opts.connections; ++i) {
+        size_t t = i % opts.threads;
+        auto source = asio::ip::make_address_v4("127.0.0." + std::to_string(1 + i % opts.sourceIps));
+        std::make_shared<BenchClient>(*contexts[t], stats[t], opts, i)->start(server, source);
+    }
+
+    std::vector<std::thread> workers;
+    for (auto& ctx : contexts) {
+        workers.emplace_back([&ctx] { ctx->run(); });
+    }
+
+    // Let every client connect and subscribe before the clock starts
+    std::this_thread::sleep_for(std::chrono::seconds(5));
+
+    std::atomic<bool> running{true};
+    std::thread publisher(publish, std::cref(opts), std::ref(running));
+    std::this_thread::sleep_for(std::chrono::seconds(opts.duration));
+    running = false;
+    publisher.join();
+
+    // Allow in-flight ticks to arrive
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    for (auto& ctx : contexts) ctx->stop();
+    for (auto& worker : workers) worker.join();
+
+    Stats total;
+    for (const auto& s : stats) total.merge(s);
+
+    std::cout << "connections=" << total.connected << "/" << opts.connections
+              << " errors=" << total.errors
+              << " messages=" << total.messages
+              << " msgs_per_sec=" << total.messages / std::max(opts.duration, 1)
+              << " p50_us=" << total.percentileMicros(0.50)
+              << " p99_us=" << total.percentileMicros(0.99)
+              << " p999_us=" << total.percentileMicros(0.999) << std::endl;
+    return 0;
+}
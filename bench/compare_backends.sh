@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+# Builds the service with the epoll and io_uring backends and runs FanoutBench against each at
+# 10k / 50k / 100k connections. Needs a local Redis, liburing, Boost >= 1.78 and a high `ulimit -n`.
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+CONNECTIONS="${CONNECTIONS:-10000 50000 100000}"
+RATE="${RATE:-100}"
+DURATION="${DURATION:-30}"
+THREADS="${THREADS:-4}"
+
+# Server and clients run on this host, so each connection needs a descriptor in both processes
+ulimit -n 1048576 2>/dev/null || ulimit -n "$(ulimit -Hn)"
+FD_LIMIT=$(ulimit -n)
+
+for backend in epoll io_uring; do
+    build="$ROOT/_bench_$backend"
+    uring=OFF
+    [ "$backend" = io_uring ] && uring=ON
+    if ! cmake -S "$ROOT" -B "$build" -DCMAKE_BUILD_TYPE=Release -DSOCKETSERVICE_IO_URING=$uring -DSOCKETSERVICE_BUILD_BENCH=ON >/dev/null \
+        || ! cmake --build "$build" -j"$(nproc)" >/dev/null; then
+        echo "backend=$backend skipped: build failed"
+        continue
+    fi
+
+    for n in $CONNECTIONS; do
+        if [ "$n" -ge $(( FD_LIMIT - 100 )) ]; then
+            echo "backend=$backend connections=$n skipped: ulimit -n is $FD_LIMIT"
+            continue
+        fi
+        "$build/SocketService" >/dev/null 2>&1 &
+        server=$!
+        sleep 1
+        result=$("$build/FanoutBench" --connections "$n" --rate "$RATE" --duration "$DURATION" \
+                 --threads "$THREADS" --source-ips $(( n / 25000 + 1 )))
+        kill "$server"; wait "$server" 2>/dev/null || true
+        echo "backend=$backend $result"
+    done
+done
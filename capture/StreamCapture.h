@@ -0,0 +1,33 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_STREAMCAPTURE_H
+#define SOCKETSERVICE_STREAMCAPTURE_H
+
+#include <cstdint>
+
+/*
+ * On-disk layout of a stream capture, shared by StreamRecorder and StreamReplayer.
+ *
+ *   file   := magic record*
+ *   record := RecordHeader symbol[symbolLength] id[idLength] payload[payloadLength]
+ *
+ * Integers are in host byte order; captures are meant to be replayed on the machine type that
+ * recorded them. A truncated last record (crash while writing) is ignored on replay.
+ */
+namespace StreamCapture {
+
+constexpr char magic[8] = {'S', 'S', 'C', 'A', 'P', '0', '0', '1'};
+
+struct RecordHeader {
+    int64_t receivedAtNanos;     // system clock when the entry was read from Redis
+    uint32_t payloadLength;
+    uint16_t symbolLength;
+    uint16_t idLength;
+};
+static_assert(sizeof(RecordHeader) == 16, "capture records must have no padding");
+
+}
+
+#endif //SOCKETSERVICE_STREAMCAPTURE_H
@@ -0,0 +1,60 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#include <iostream>
+#include <cstring>
+
+#include "StreamRecorder.h"
+#include "StreamCapture.h"
+
+std::atomic<std::FILE*> StreamRecorder::file{nullptr};
+std::mutex StreamRecorder::mutex;
+
+bool StreamRecorder::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::FILE* capture = std::fopen(path.c_str(), "ab");
+    if (!capture) {
+        std::cerr << "Cannot open capture file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Opened for append, so an existing file is never truncated by mistake
+    std::fseek(capture, 0, SEEK_END);
+    if (std::ftell(capture) != 0) {
+        std::cerr << "Capture file " << path << " is not empty, record to a new file" << std::endl;
+        std::fclose(capture);
+        return false;
+    }
+    // Large buffer so recording costs a memcpy per entry and a write per MB, not a syscall per tick
+    std::setvbuf(capture, nullptr, _IOFBF, 1 << 20);
+    std::fwrite(StreamCapture::magic, 1, sizeof(StreamCapture::magic), capture);
+
+    file.store(capture, std::memory_order_release);
+    std::cout << "Recording stream entries to " << path << std::endl;
+    return true;
+}
+
+void StreamRecorder::record(std::string_view symbol, std::string_view id, std::string_view payload, int64_t receivedAtNanos) {
+    StreamCapture::RecordHeader header{
+            receivedAtNanos,
+            static_cast<uint32_t>(payload.size()),
+            static_cast<uint16_t>(symbol.size()),
+            static_cast<uint16_t>(id.size())};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::FILE* capture = file.load(std::memory_order_relaxed);
+    if (!capture) {
+        return;
+    }
+    std::fwrite(&header, sizeof(header), 1, capture);
+    std::fwrite(symbol.data(), 1, symbol.size(), capture);
+    std::fwrite(id.data(), 1, id.size(), capture);
+    std::fwrite(payload.data(), 1, payload.size(), capture);
+}
+
+void StreamRecorder::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (std::FILE* capture = file.exchange(nullptr)) {
+        std::fclose(capture);
+    }
+}
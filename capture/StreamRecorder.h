@@ -0,0 +1,35 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_STREAMRECORDER_H
+#define SOCKETSERVICE_STREAMRECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/*
+ * Capture mode: appends every stream entry the service ingests to a binary file (see StreamCapture.h)
+ * so real market traffic can be replayed offline. Shared by all stream consumer threads.
+ *
+ * A capture holds exactly one recording session, so open() refuses a file that already has content:
+ * appending a second session would make replay sleep through the gap between the two.
+ */
+class StreamRecorder {
+public:
+    static bool open(const std::string& path);
+    static bool enabled() { return file.load(std::memory_order_acquire) != nullptr; }
+    static void record(std::string_view symbol, std::string_view id, std::string_view payload, int64_t receivedAtNanos);
+    static void close();
+
+private:
+    // Written under mutex, read without it by enabled()
+    static std::atomic<std::FILE*> file;
+    static std::mutex mutex;
+};
+
+#endif //SOCKETSERVICE_STREAMRECORDER_H
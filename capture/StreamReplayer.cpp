@@ -0,0 +1,161 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#include <iostream>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <hiredis/hiredis.h>
+#include <boost/json.hpp>
+
+#include "StreamReplayer.h"
+#include "StreamCapture.h"
+#include "../server/SymbolBroadcaster.h"
+#include "../utils/CpuPlacement.h"
+
+bool StreamReplayer::start(const Options& options) {
+    int fd = ::open(options.path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        std::cerr << "Cannot open capture " << options.path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+
+    auto size = static_cast<size_t>(st.st_size);
+    if (size < sizeof(StreamCapture::magic)) {
+        std::cerr << "Capture " << options.path << " is empty\n";
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Cannot map capture " << options.path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (std::memcmp(mapped, StreamCapture::magic, sizeof(StreamCapture::magic)) != 0) {
+        std::cerr << options.path << " is not a stream capture\n";
+        ::munmap(mapped, size);
+        return false;
+    }
+    // Read once front to back
+    ::madvise(mapped, size, MADV_SEQUENTIAL);
+
+    std::thread(&StreamReplayer::run, options, static_cast<const char*>(mapped), size).detach();
+    return true;
+}
+
+void StreamReplayer::run(Options options, const char* data, size_t size) {
+    // the replayer stands in for the stream readers, so it runs where they would
+    CpuPlacement::pinCurrentThread(CpuPlacement::Role::Ingest);
+    std::this_thread::sleep_for(options.startDelay);
+
+    redisContext* redisCtx = nullptr;
+    if (options.target == Target::Redis) {
+        redisCtx = redisConnect("127.0.0.1", 6379);
+        if (redisCtx == nullptr || redisCtx->err) {
+            std::cerr << "Replay cannot connect to Redis\n";
+            if (redisCtx) redisFree(redisCtx);
+            ::munmap(const_cast<char*>(data), size);
+            return;
+        }
+    }
+
+    std::unordered_map<std::string, SymbolBroadcaster> broadcasters;
+    size_t offset = sizeof(StreamCapture::magic);
+    size_t entries = 0;
+    int64_t firstRecordedAt = 0;
+    auto replayStart = std::chrono::steady_clock::now();
+
+    /*
+     * Sleeps until the next entry is due. Rate-limited views still flush on their own schedule in
+     * between, as they do in consumeStream through its XREAD timeout.
+     */
+    auto waitUntil = [&](std::chrono::steady_clock::time_point until) {
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            std::optional<std::chrono::steady_clock::time_point> flushAt;
+            for (const auto& [symbol, broadcaster] : broadcasters) {
+                if (auto due = broadcaster.nextDue(); due && (!flushAt || now + *due < *flushAt)) {
+                    flushAt = now + *due;
+                }
+            }
+            if (!flushAt || *flushAt >= until) {
+                break;
+            }
+            std::this_thread::sleep_until(*flushAt);
+            for (auto& [symbol, broadcaster] : broadcasters) {
+                broadcaster.flushDue();
+            }
+        }
+        std::this_thread::sleep_until(until);
+    };
+
+    std::cout << "Replaying " << options.path << " at "
+              << (options.speed > 0 ? std::to_string(options.speed) + "x" : std::string("max speed")) << std::endl;
+
+    while (offset + sizeof(StreamCapture::RecordHeader) <= size) {
+        StreamCapture::RecordHeader header{};
+        std::memcpy(&header, data + offset, sizeof(header));
+        size_t recordSize = sizeof(header) + header.symbolLength + header.idLength + header.payloadLength;
+        if (offset + recordSize > size) {
+            break;  // truncated tail
+        }
+
+        const char* cursor = data + offset + sizeof(header);
+        std::string symbol(cursor, header.symbolLength);
+        cursor += header.symbolLength;
+        std::string id(cursor, header.idLength);
+        cursor += header.idLength;
+        std::string_view payload(cursor, header.payloadLength);
+        offset += recordSize;
+
+        if (entries++ == 0) {
+            firstRecordedAt = header.receivedAtNanos;
+        } else if (options.speed > 0) {
+            auto recordedOffset = std::chrono::nanoseconds(header.receivedAtNanos - firstRecordedAt);
+            auto scaled = std::chrono::duration_cast<std::chrono::steady_clock::duration>(recordedOffset / options.speed);
+            waitUntil(replayStart + scaled);
+        }
+
+        if (options.target == Target::Redis) {
+            // New IDs, the original ones may sit below the stream's current last ID
+            auto* reply = (redisReply*) redisCommand(redisCtx, "XADD %s * payload %b",
+                                                     symbol.c_str(), payload.data(), payload.size());
+            if (reply) freeReplyObject(reply);
+            continue;
+        }
+
+        boost::json::value streamData;
+        try {
+            streamData = boost::json::parse(payload);
+        } catch (...) {
+            continue;  // recorded as received, consumeStream skips these too
+        }
+        auto& broadcaster = broadcasters.try_emplace(symbol, symbol).first->second;
+        broadcaster.publish(streamData, id);
+        broadcaster.flushDue();
+    }
+
+    // Conflated ticks still pending go out once their interval has passed
+    for (auto& [symbol, broadcaster] : broadcasters) {
+        while (auto due = broadcaster.nextDue()) {
+            std::this_thread::sleep_for(*due);
+            broadcaster.flushDue();
+        }
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+    std::cout << "Replay finished: " << entries << " entries in " << elapsed << "s" << std::endl;
+
+    if (redisCtx) redisFree(redisCtx);
+    ::munmap(const_cast<char*>(data), size);
+}
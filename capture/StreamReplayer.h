@@ -0,0 +1,35 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_STREAMREPLAYER_H
+#define SOCKETSERVICE_STREAMREPLAYER_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/*
+ * Replays a capture written by StreamRecorder. The file is memory-mapped and walked in order, either
+ * straight into the fan-out engine (no Redis needed) or XADDed into a local Redis so the whole ingest
+ * path runs. Entry spacing follows the recorded receive timestamps, scaled by speed.
+ */
+class StreamReplayer {
+public:
+    enum class Target { Fanout, Redis };
+
+    struct Options {
+        std::string path;
+        double speed = 1.0;                       // 1 = real time, N = N times faster, 0 = as fast as possible
+        Target target = Target::Fanout;
+        std::chrono::seconds startDelay{0};       // time for clients to connect and subscribe first
+    };
+
+    // Maps the file and starts replaying on a background thread, false if the file is unusable
+    static bool start(const Options& options);
+
+private:
+    static void run(Options options, const char* data, size_t size);
+};
+
+#endif //SOCKETSERVICE_STREAMREPLAYER_H
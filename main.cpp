@@ -1,22 +1,158 @@
 #include <iostream>
+#include <cmath>
+#include <memory>
+#include <functional>
 #include "redisHandler/RedisConsumer.h"
 #include "server/WebSocketServer.h"
+#include "server/SocketHandoff.h"
+#include "server/WebSocketSession.h"
+#include "server/MemoryReport.h"
+#include "capture/StreamRecorder.h"
+#include "capture/StreamReplayer.h"
+#include "utils/CpuPlacement.h"
 
 using namespace std;
 
-int main() {
+// Whole-string parsing, so a typo in an option value is reported instead of silently truncated
+static bool parseNumber(const std::string& text, double& value) {
+    try {
+        size_t parsed = 0;
+        value = std::stod(text, &parsed);
+        return parsed == text.size() && std::isfinite(value);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+static bool parseNumber(const std::string& text, int& value) {
+    try {
+        size_t parsed = 0;
+        value = std::stoi(text, &parsed);
+        return parsed == text.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+static int usageError(const std::string& option, const std::string& value, const char* expected) {
+    std::cerr << "Invalid value '" << value << "' for " << option << ", expected " << expected << std::endl;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    // --takeover: adopt the listener and clients of the instance already running, for zero-downtime deploys
+    // --record <file>: capture every ingested stream entry; --replay <file>: serve a capture instead of Redis
+    bool takeover = false;
+    std::string handoffPath = "/tmp/socket-service.sock";
+    std::string recordPath;
+    StreamReplayer::Options replay;
+    // --io-cpus / --ingest-cpus <list>: pin the io thread and the stream readers, e.g. "0-3,8"
+    std::string ioCpus, ingestCpus;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--takeover") {
+            takeover = true;
+        } else if (arg == "--handoff-path" && i + 1 < argc) {
+            handoffPath = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay.path = argv[++i];
+        } else if (arg == "--replay-speed" && i + 1 < argc) {
+            // "1", "10x" or "max"
+            std::string speed = argv[++i];
+            std::string factor = !speed.empty() && speed.back() == 'x' ? speed.substr(0, speed.size() - 1) : speed;
+            if (speed == "max") {
+                replay.speed = 0;
+            } else if (!parseNumber(factor, replay.speed) || replay.speed <= 0) {
+                return usageError(arg, speed, "a positive number, Nx or max");
+            }
+        } else if (arg == "--replay-target" && i + 1 < argc) {
+            std::string target = argv[++i];
+            if (target == "redis") {
+                replay.target = StreamReplayer::Target::Redis;
+            } else if (target == "fanout") {
+                replay.target = StreamReplayer::Target::Fanout;
+            } else {
+                return usageError(arg, target, "fanout or redis");
+            }
+        } else if (arg == "--replay-delay" && i + 1 < argc) {
+            int seconds = 0;
+            if (!parseNumber(argv[++i], seconds) || seconds < 0) {
+                return usageError(arg, argv[i], "a number of seconds");
+            }
+            replay.startDelay = std::chrono::seconds(seconds);
+        } else if (arg == "--io-cpus" && i + 1 < argc) {
+            ioCpus = argv[++i];
+        } else if (arg == "--ingest-cpus" && i + 1 < argc) {
+            ingestCpus = argv[++i];
+        }
+    }
+
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+    std::cout << "Network backend: io_uring" << std::endl;
+#else
+    std::cout << "Network backend: epoll" << std::endl;
+#endif
+
+    // main becomes the io thread, pin it before anything it owns is allocated
+    CpuPlacement::configure(ioCpus, ingestCpus);
+    CpuPlacement::pinCurrentThread(CpuPlacement::Role::Io);
+    CpuPlacement::reportTopology();
+
+    // Replaying straight into fan-out needs no Redis; left uninitialized, stream consumers exit right away
+    bool replayToFanout = !replay.path.empty() && replay.target == StreamReplayer::Target::Fanout;
+    if (!replayToFanout) {
 //    replace it with your actual redis endpoint
-    RedisConsumer::initialize("127.0.0.1:6379");
+        RedisConsumer::initialize("127.0.0.1:6379");
+    }
+    if (!recordPath.empty() && !StreamRecorder::open(recordPath)) {
+        return 1;
+    }
 
     try {
         asio::io_context ioContext;
-        WebSocketServer server(ioContext, 8000);
-        server.start();
+
+        int listenerFd = takeover ? SocketHandoff::takeover(ioContext, handoffPath) : -1;
+        auto server = listenerFd >= 0
+                ? WebSocketServer::fromListener(ioContext, listenerFd)
+                : std::make_unique<WebSocketServer>(ioContext, 8000);
+        server->start();
+        SocketHandoff::listen(ioContext, *server, handoffPath);
+
+        // kill -USR1 <pid> logs memory use per connection state
+        asio::signal_set reportSignal(ioContext, SIGUSR1);
+        std::function<void(const boost::system::error_code&, int)> onReportSignal =
+                [&](const boost::system::error_code& ec, int) {
+                    if (ec) return;
+                    MemoryReport::log();
+                    reportSignal.async_wait(onReportSignal);
+                };
+        reportSignal.async_wait(onReportSignal);
+
+        // Ctrl-C / SIGTERM stop the io loop so the shutdown below runs, which flushes a capture being recorded
+        asio::signal_set stopSignals(ioContext, SIGINT, SIGTERM);
+        stopSignals.async_wait([&](const boost::system::error_code& ec, int signal) {
+            if (ec) return;
+            std::cout << "Received signal " << signal << ", shutting down." << std::endl;
+            ioContext.stop();
+        });
+
+        if (!replay.path.empty()) {
+            StreamReplayer::start(replay);
+        }
+
         ioContext.run();
+
+        // Sockets and timers must not outlive ioContext, and the globals holding them are destroyed after it
+        SocketHandoff::stop();
+        WebSocketSession::disconnectAll();
     } catch (const std::exception& e) {
         std::cerr << "Server Error: " << e.what() << std::endl;
     }
 
+    // Consumers may still be running, so the capture is closed before their Redis connection goes away
+    StreamRecorder::close();
     RedisConsumer::shutdown();
 
     return 0;
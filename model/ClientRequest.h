@@ -5,6 +5,9 @@
 #ifndef SOCKETSERVICE_CLIENTREQUEST_H
 #define SOCKETSERVICE_CLIENTREQUEST_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <boost/json.hpp>
@@ -15,6 +18,11 @@ public:
     std::vector<std::string> value;
     std::string userId;
 
+    // optional on subscribe, see SubscriptionView
+    std::vector<std::string> fields;
+    int maxRate = 0;
+    static constexpr int maxRateLimit = 1000;   // updates per second
+
     explicit ClientRequest(const boost::json::value& json) {
         if (json.is_object()) {
             const auto& obj = json.as_object();
@@ -31,6 +39,24 @@ public:
             if (obj.contains("userId") && obj.at("userId").is_string()) {
                 userId = obj.at("userId").as_string().c_str();
             }
+            if (obj.contains("fields") && obj.at("fields").is_array()) {
+                for (const auto& val : obj.at("fields").as_array()) {
+                    if (val.is_string()) {
+                        fields.push_back(val.as_string().c_str());
+                    }
+                }
+            }
+            if (obj.contains("maxRate")) {
+                const auto& rate = obj.at("maxRate");
+                // clamped before the cast, anything not a finite number means every tick
+                if (rate.is_int64()) {
+                    maxRate = static_cast<int>(std::clamp<int64_t>(rate.as_int64(), 0, maxRateLimit));
+                } else if (rate.is_uint64()) {
+                    maxRate = static_cast<int>(std::min<uint64_t>(rate.as_uint64(), maxRateLimit));
+                } else if (rate.is_double() && std::isfinite(rate.as_double())) {
+                    maxRate = static_cast<int>(std::clamp(rate.as_double(), 0.0, double(maxRateLimit)));
+                }
+            }
         }
     }
 };
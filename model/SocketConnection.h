@@ -5,24 +5,55 @@
 #ifndef SOCKETSERVICE_SOCKETCONNECTION_H
 #define SOCKETSERVICE_SOCKETCONNECTION_H
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <mutex>
+#include <vector>
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
+#include <boost/container/small_vector.hpp>
 
 namespace asio = boost::asio;
 namespace beast = boost::beast;
-namespace websocket = beast::websocket;
 using tcp = asio::ip::tcp;
 
+/*
+ * Everything the service keeps per client lives in this one object, sized for holding a very large
+ * number of mostly idle connections:
+ *  - the client's socket, without a websocket stream around it
+ *  - a heartbeat timer on the io thread instead of a thread per connection
+ *  - subscribed symbols inline for the common case of a handful of symbols
+ *  - a read buffer and frame queue that are released again once drained
+ * A websocket stream only exists during the handshake (see WebSocketSession::start), frames are read
+ * and written on the socket directly (FrameReader, FrameWriter).
+ */
 class SocketConnection {
 public:
+    using SymbolList = boost::container::small_vector<std::string, 2>;
+
     std::string connId;
-    std::shared_ptr<websocket::stream<tcp::socket>> conn;
+    tcp::socket socket;
+
+    // Encoded websocket frames waiting to be written, guarded by mutex (see FrameWriter)
     std::mutex mutex;
+    std::vector<std::shared_ptr<const std::string>> controlFrames;
+    std::vector<std::shared_ptr<const std::string>> pendingFrames;
+    size_t queuedBytes = 0;   // in both queues, capped (see FrameWriter::maxQueuedBytes)
+    bool writing = false;
+    bool closing = false;   // close frame queued, nothing else is sent
+    std::chrono::steady_clock::time_point writeStartedAt;   // last time a write was started
+
+    // Only touched from the io thread
+    SymbolList symbols;
+    beast::flat_buffer readBuffer;
+    std::string partialMessage;   // fragments of a message still being received
+    bool fragmented = false;
+    asio::steady_timer heartbeatTimer;
+    std::chrono::steady_clock::time_point lastMessageAt = std::chrono::steady_clock::now();
 
-    SocketConnection(std::string id, std::shared_ptr<websocket::stream<tcp::socket>> ws)
-        : connId(std::move(id)), conn(std::move(ws)) {}
+    SocketConnection(std::string id, tcp::socket client)
+        : connId(std::move(id)), socket(std::move(client)), heartbeatTimer(socket.get_executor()) {}
 
     // deleting copy constructors to avoid accidental copying
     SocketConnection(const SocketConnection&) = delete;
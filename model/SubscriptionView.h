@@ -0,0 +1,71 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_SUBSCRIPTIONVIEW_H
+#define SOCKETSERVICE_SUBSCRIPTIONVIEW_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/json.hpp>
+
+#include "SocketConnection.h"
+
+/*
+ * What a subscriber wants out of a symbol's ticks: a subset of the payload fields and/or a cap on
+ * updates per second. Subscribers asking for the same view share one projected frame per tick, so
+ * the cost is per distinct view and not per connection.
+ */
+class SubscriptionView {
+public:
+    std::vector<std::string> fields;   // empty -> whole payload
+    int maxRate = 0;                   // updates per second, 0 -> every tick
+
+    SubscriptionView() : key_("*|0") {}
+
+    SubscriptionView(std::vector<std::string> requestedFields, int requestedRate)
+        : fields(std::move(requestedFields)), maxRate(std::max(requestedRate, 0)) {
+        std::sort(fields.begin(), fields.end());
+        fields.erase(std::unique(fields.begin(), fields.end()), fields.end());
+
+        // canonical form, two views are the same view iff their keys are equal. Fields are length
+        // prefixed since a field name may itself contain ',' or '|'
+        key_.clear();
+        for (const auto& field : fields) {
+            key_ += std::to_string(field.size());
+            key_ += ':';
+            key_ += field;
+        }
+        if (fields.empty()) key_ = "*";
+        key_ += '|' + std::to_string(maxRate);
+    }
+
+    const std::string& key() const { return key_; }
+
+    boost::json::value project(const boost::json::value& data) const {
+        if (fields.empty() || !data.is_object()) {
+            return data;
+        }
+        boost::json::object projected;
+        const auto& obj = data.as_object();
+        for (const auto& field : fields) {
+            if (obj.contains(field)) {
+                projected[field] = obj.at(field);
+            }
+        }
+        return projected;
+    }
+
+private:
+    std::string key_;
+};
+
+// All connections subscribed to one symbol with the same view
+struct SubscriberGroup {
+    std::shared_ptr<const SubscriptionView> view;
+    std::vector<std::shared_ptr<SocketConnection>> connections;
+};
+
+#endif //SOCKETSERVICE_SUBSCRIPTIONVIEW_H
@@ -2,17 +2,20 @@
 // Created by Satyam Saurabh on 02/03/25.
 //
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <thread>
-#include <future>
 #include <mutex>
 #include <hiredis/hiredis.h>
 #include <boost/json.hpp>
 
 #include "RedisConsumer.h"
 #include "../utils/GlobalMaps.h"
-#include "../server/WebSocketSession.h"
+#include "../server/SymbolBroadcaster.h"
+#include "../capture/StreamRecorder.h"
+#include "../utils/CpuPlacement.h"
 
 redisContext* RedisConsumer::redisCtx = nullptr;
 std::thread RedisConsumer::ioThread;
@@ -37,113 +40,102 @@ void RedisConsumer::initialize(const std::string& redisAddr) {
     }
 }
 
-void RedisConsumer::consumeStream(const std::string& symbol) {
+void RedisConsumer::consumeStream(const std::string& symbol, std::string startID) {
     std::cout << "Starting Redis Stream consumption for symbol: " << symbol << std::endl;
-    std::string startID = "$";  // Start from the latest message
+    CpuPlacement::pinCurrentThread(CpuPlacement::Role::Ingest);
 
     if (!redisCtx) {
         std::cerr << "Redis client is not initialized.\n";
         return;
     }
 
+    SymbolBroadcaster broadcaster(symbol);
+
+    /*
+     * What a successor resumes from after a handoff. Queued frames are forwarded with the sockets,
+     * but ticks held back by conflation live only here, so the offset stays before the oldest of them.
+     */
+    auto saveOffset = [&] {
+        if (auto offset = broadcaster.resumeOffset()) {
+            streamOffsetMap.insert(symbol, *offset);
+        }
+    };
+
     while (true) {
         std::cout << "startId - " << startID << std::endl;
 
-        auto* reply = (redisReply*) redisCommand(redisCtx, "XREAD BLOCK 0 COUNT 1 STREAMS %s %s", symbol.c_str(), startID.c_str());
+        // Block until the next entry, or only until a conflated tick is due for a rate-limited view
+        auto due = broadcaster.nextDue();
+        long long blockMs = due ? std::max<long long>(due->count(), 1) : 0;
+
+        auto* reply = (redisReply*) redisCommand(redisCtx, "XREAD BLOCK %lld COUNT 1 STREAMS %s %s", blockMs, symbol.c_str(), startID.c_str());
+        auto receivedAt = std::chrono::system_clock::now();
         if (!reply) {
             std::cerr << "Error reading from Redis stream: " << redisCtx->errstr << std::endl;
             continue;
         }
 
         if (reply->type == REDIS_REPLY_NIL || reply->elements == 0) {
-            std::cerr << "No messages received.\n";
             freeReplyObject(reply);
+            broadcaster.flushDue();
+            saveOffset();
             continue;
         }
 
-        boost::json::object clientData;
-        try {
-            std::string messageID;
-            std::string payload;
-
-            if (reply->type == REDIS_REPLY_ARRAY && reply->elements > 0) {
-                auto stream = reply->element[0];
-                if (stream->type == REDIS_REPLY_ARRAY && stream->elements > 1) {
-                    auto messages = stream->element[1];
-
-                    if (messages->type == REDIS_REPLY_ARRAY && messages->elements > 0) {
-                        auto message = messages->element[0];
-
-                        if (message->type == REDIS_REPLY_ARRAY && message->elements > 1) {
-                            messageID = message->element[0]->str;
-                            for (size_t i = 1; i < message->elements; i += 2) {
-                                std::string key = message->element[i]->str;
-                                std::string value = message->element[i + 1]->str;
-                                if (key == "payload") {
-                                    payload = value;
-                                }
+        std::string messageID;
+        std::string payload;
+        if (reply->type == REDIS_REPLY_ARRAY && reply->elements > 0) {
+            auto stream = reply->element[0];
+            if (stream->type == REDIS_REPLY_ARRAY && stream->elements > 1) {
+                auto messages = stream->element[1];
+
+                if (messages->type == REDIS_REPLY_ARRAY && messages->elements > 0) {
+                    auto message = messages->element[0];
+
+                    // [id, [field, value, field, value, ...]]
+                    if (message->type == REDIS_REPLY_ARRAY && message->elements > 1 && message->element[0]->str) {
+                        messageID = message->element[0]->str;
+                        auto fields = message->element[1];
+                        for (size_t i = 0; fields->type == REDIS_REPLY_ARRAY && i + 1 < fields->elements; i += 2) {
+                            auto key = fields->element[i];
+                            auto value = fields->element[i + 1];
+                            if (key->str && value->str && std::string_view(key->str, key->len) == "payload") {
+                                payload.assign(value->str, value->len);
                             }
                         }
                     }
                 }
             }
+        }
+        freeReplyObject(reply);
 
-            if (payload.empty()) {
-                std::cerr << "No payload found in message.\n";
-                freeReplyObject(reply);
-                continue;
-            }
-
-            boost::json::value streamData = boost::json::parse(payload);
-            clientData["data"] = streamData;
-            clientData["type"] = "marketfeed";
-
-            // Update startID for next iteration
-            if (!messageID.empty()) {
-                startID = messageID;
-            }
+        /*
+         * Every entry is read, and recorded, exactly once. The ID advances before the payload is
+         * looked at, so a malformed entry is skipped instead of being read again forever.
+         */
+        if (!messageID.empty()) {
+            startID = messageID;
+        }
+        if (payload.empty()) {
+            std::cerr << "No payload found in message.\n";
+            continue;
+        }
+        if (StreamRecorder::enabled()) {
+            StreamRecorder::record(symbol, messageID, payload,
+                                   std::chrono::duration_cast<std::chrono::nanoseconds>(receivedAt.time_since_epoch()).count());
+        }
 
+        boost::json::value streamData;
+        try {
+            streamData = boost::json::parse(payload);
         } catch (const std::exception& e) {
             std::cerr << "Error parsing message payload: " << e.what() << std::endl;
-            freeReplyObject(reply);
             continue;
         }
 
-        freeReplyObject(reply);
-
-        auto connectionListOpt = symbolConnectionMap.find(symbol);
-        if (connectionListOpt) {
-            auto connectionList = connectionListOpt.value();
-            std::vector<std::future<void>> tasks;
-
-            /*
-             * While broadcast, for each connection we are using a separate thread to send message
-             * to the client.
-             * This helps us in two ways:
-             *   1. For faster execution of broadcasting logic
-             *   2. If broadcast to one connection fails, it will not impact broadcasting to other connections.
-             */
-            for (const auto& conn : connectionList) {
-                tasks.push_back(std::async(std::launch::async, [conn, clientData, symbol] {
-                    std::lock_guard<std::mutex> lock(conn->mutex);
-                    boost::system::error_code ec;
-                    conn->conn->write(boost::asio::buffer(boost::json::serialize(clientData)), ec);
-                    if (ec) {
-                        std::cerr << "Error sending data to client " << conn->connId
-                                  << " for stream " << symbol << ": " << ec.message() << std::endl;
-                        WebSocketSession::handleDisconnection(conn);
-                        return;
-                    }
-                }));
-            }
-
-            /*
-             * This will allow us to send one tick to all the connections subscribed to it before
-             * moving to the next tick data, keeping the frequency of the ticks the same for all clients.
-             */
-            for (auto& task : tasks) {
-                task.get();
-            }
+        if (broadcaster.publish(streamData, messageID)) {
+            broadcaster.flushDue();
+            saveOffset();
         } else {
             std::cout << "conn list not found for symbol - " << symbol << ". Closing stream connection" << std::endl;
             streamStatusMap.insert(symbol, false);
@@ -13,7 +13,8 @@
 class RedisConsumer {
 public:
     static void initialize(const std::string& redisAddr);
-    static void consumeStream(const std::string& symbol);
+    // startID defaults to "$" (latest); a successor process passes the last ID its predecessor broadcast
+    static void consumeStream(const std::string& symbol, std::string startID = "$");
     static void shutdown();
 
 private:
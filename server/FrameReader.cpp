@@ -0,0 +1,72 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#include <cstdint>
+
+#include "FrameReader.h"
+
+FrameReader::Status FrameReader::parse(char* data, size_t size, size_t maxPayload, Frame& frame, size_t& frameSize) {
+    frameSize = 0;
+    if (size < 2) {
+        return Status::Incomplete;
+    }
+    auto first = static_cast<unsigned char>(data[0]);
+    auto second = static_cast<unsigned char>(data[1]);
+
+    // No extension is negotiated, so reserved bits must be clear, and clients must mask every frame
+    if ((first & 0x70) != 0 || (second & 0x80) == 0) {
+        return Status::ProtocolError;
+    }
+    auto opcode = static_cast<FrameWriter::Opcode>(first & 0x0F);
+    bool fin = (first & 0x80) != 0;
+    bool control = (first & 0x08) != 0;
+    switch (opcode) {
+        case FrameWriter::Opcode::Continuation:
+        case FrameWriter::Opcode::Text:
+        case FrameWriter::Opcode::Binary:
+        case FrameWriter::Opcode::Close:
+        case FrameWriter::Opcode::Ping:
+        case FrameWriter::Opcode::Pong:
+            break;
+        default:
+            return Status::ProtocolError;
+    }
+
+    uint64_t length = second & 0x7F;
+    size_t headerSize = 2;
+    if (length == 126) {
+        headerSize = 4;
+    } else if (length == 127) {
+        headerSize = 10;
+    }
+    if (control && (length > 125 || !fin)) {
+        return Status::ProtocolError;
+    }
+    if (size < headerSize) {
+        return Status::Incomplete;
+    }
+    if (headerSize > 2) {
+        length = 0;
+        for (size_t i = 2; i < headerSize; ++i) {
+            length = (length << 8) | static_cast<unsigned char>(data[i]);
+        }
+    }
+    if (length > maxPayload) {
+        return Status::TooBig;
+    }
+
+    const char* mask = data + headerSize;
+    headerSize += 4;
+    frameSize = headerSize + length;
+    if (size < frameSize) {
+        return Status::Incomplete;
+    }
+
+    char* payload = data + headerSize;
+    for (size_t i = 0; i < length; ++i) {
+        payload[i] ^= mask[i % 4];
+    }
+    frame = Frame{opcode, fin, std::string_view(payload, length)};
+    return Status::Complete;
+}
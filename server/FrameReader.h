@@ -0,0 +1,37 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_FRAMEREADER_H
+#define SOCKETSERVICE_FRAMEREADER_H
+
+#include <cstddef>
+#include <string_view>
+
+#include "FrameWriter.h"
+
+/*
+ * Decodes client -> server websocket frames straight from the socket's read buffer.
+ *
+ * Beast only performs the handshake. Its read loop answers pings and close frames by writing to the
+ * socket on its own, which would land in the middle of a FrameWriter gather write. Reading below Beast
+ * leaves FrameWriter as the only writer, and pongs and close replies go through its control lane.
+ */
+class FrameReader {
+public:
+    enum class Status { Complete, Incomplete, ProtocolError, TooBig };
+
+    struct Frame {
+        FrameWriter::Opcode opcode;
+        bool fin;
+        std::string_view payload;   // unmasked in place, points into the parsed buffer
+    };
+
+    /*
+     * Parses the frame at the front of data. On Complete, frameSize is the number of bytes it used.
+     * On Incomplete, frameSize is the total size of the frame once its header is in, 0 before that.
+     */
+    static Status parse(char* data, size_t size, size_t maxPayload, Frame& frame, size_t& frameSize);
+};
+
+#endif //SOCKETSERVICE_FRAMEREADER_H
@@ -0,0 +1,211 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#include <iostream>
+#include <vector>
+
+#include "FrameWriter.h"
+#include "WebSocketSession.h"
+#include "../utils/GlobalMaps.h"
+
+std::atomic<bool> FrameWriter::paused{false};
+
+FrameWriter::Frame FrameWriter::encode(Opcode opcode, std::string_view payload) {
+    std::string frame;
+    frame.reserve(payload.size() + 10);
+    frame.push_back(static_cast<char>(0x80 | static_cast<uint8_t>(opcode)));  // FIN + opcode
+
+    size_t length = payload.size();
+    if (length < 126) {
+        frame.push_back(static_cast<char>(length));
+    } else if (length <= 0xFFFF) {
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>((length >> 8) & 0xFF));
+        frame.push_back(static_cast<char>(length & 0xFF));
+    } else {
+        frame.push_back(static_cast<char>(127));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame.push_back(static_cast<char>((static_cast<uint64_t>(length) >> shift) & 0xFF));
+        }
+    }
+    frame.append(payload);
+    return std::make_shared<const std::string>(std::move(frame));
+}
+
+FrameWriter::Opcode FrameWriter::opcode(const Frame& frame) {
+    return static_cast<Opcode>((*frame)[0] & 0x0F);
+}
+
+std::string_view FrameWriter::payload(const Frame& frame) {
+    auto length = static_cast<unsigned char>((*frame)[1]);
+    size_t headerSize = length < 126 ? 2 : (length == 126 ? 4 : 10);
+    return std::string_view(*frame).substr(headerSize);
+}
+
+void FrameWriter::send(const std::shared_ptr<SocketConnection>& conn, Frame frame, Lane lane) {
+    bool overflow = false;
+    {
+        std::lock_guard<std::mutex> lock(conn->mutex);
+        if (conn->closing) {
+            return;
+        }
+        conn->queuedBytes += frame->size();
+        if (conn->queuedBytes > maxQueuedBytes) {
+            // nothing more is queued, and a close frame would never get past the unread data either
+            conn->controlFrames.clear();
+            conn->pendingFrames.clear();
+            conn->queuedBytes = 0;
+            conn->closing = true;
+            overflow = true;
+        } else {
+            (lane == Lane::Control ? conn->controlFrames : conn->pendingFrames).push_back(std::move(frame));
+            if (conn->writing || paused.load(std::memory_order_acquire)) {
+                // the in-flight write picks this frame up in its next batch
+                return;
+            }
+            conn->writing = true;
+            conn->writeStartedAt = std::chrono::steady_clock::now();
+        }
+    }
+    if (overflow) {
+        std::cerr << "Client " << conn->connId << " is " << maxQueuedBytes / 1024 << " KB behind, disconnecting it.\n";
+        asio::post(conn->socket.get_executor(), [conn] { WebSocketSession::handleDisconnection(conn); });
+        return;
+    }
+    asio::post(conn->socket.get_executor(), [conn] { flush(conn); });
+}
+
+void FrameWriter::sendClose(const std::shared_ptr<SocketConnection>& conn, Frame closeFrame) {
+    {
+        std::lock_guard<std::mutex> lock(conn->mutex);
+        if (conn->closing) {
+            return;
+        }
+        conn->pendingFrames.clear();
+        conn->controlFrames.push_back(std::move(closeFrame));
+        conn->queuedBytes = 0;
+        for (const auto& frame : conn->controlFrames) {
+            conn->queuedBytes += frame->size();
+        }
+        conn->closing = true;
+        if (conn->writing || paused.load(std::memory_order_acquire)) {
+            return;
+        }
+        conn->writing = true;
+        conn->writeStartedAt = std::chrono::steady_clock::now();
+    }
+    asio::post(conn->socket.get_executor(), [conn] { flush(conn); });
+}
+
+void FrameWriter::flush(const std::shared_ptr<SocketConnection>& conn) {
+    auto batch = std::make_shared<std::vector<Frame>>();
+    bool closed = false;
+    {
+        std::lock_guard<std::mutex> lock(conn->mutex);
+        if (paused.load(std::memory_order_acquire)) {
+            conn->writing = false;
+            return;
+        }
+        /*
+         * Control frames always lead the batch, so heartbeats and replies wait for at most one
+         * write. Data frames fill the rest up to a byte budget, which bounds how long a burst of
+         * ticks can hold the socket before queued control frames get their turn again.
+         */
+        auto& control = conn->controlFrames;
+        size_t controlCount = std::min(control.size(), maxBatchFrames);
+        batch->assign(std::make_move_iterator(control.begin()), std::make_move_iterator(control.begin() + controlCount));
+        control.erase(control.begin(), control.begin() + controlCount);
+
+        auto& data = conn->pendingFrames;
+        size_t dataCount = 0, dataBytes = 0;
+        while (dataCount < data.size() && batch->size() + dataCount < maxBatchFrames) {
+            size_t frameBytes = data[dataCount]->size();
+            // a single frame larger than the budget still goes out, alone
+            if (dataCount > 0 && dataBytes + frameBytes > dataBudgetBytes) break;
+            dataBytes += frameBytes;
+            ++dataCount;
+        }
+        batch->insert(batch->end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.begin() + dataCount));
+        data.erase(data.begin(), data.begin() + dataCount);
+
+        for (const auto& frame : *batch) {
+            conn->queuedBytes -= frame->size();
+        }
+        conn->writeStartedAt = std::chrono::steady_clock::now();
+
+        if (batch->empty()) {
+            conn->writing = false;
+            // a burst can leave a large queue behind, give it back once drained
+            if (data.capacity() > maxBatchFrames) {
+                data.shrink_to_fit();
+            }
+            closed = conn->closing;
+        }
+    }
+    if (batch->empty()) {
+        // the close frame is out, nothing may follow it
+        if (closed) {
+            WebSocketSession::handleDisconnection(conn);
+        }
+        return;
+    }
+
+    std::vector<asio::const_buffer> buffers;
+    buffers.reserve(batch->size());
+    for (const auto& frame : *batch) {
+        buffers.emplace_back(frame->data(), frame->size());
+    }
+
+    // Written below Beast, which is only used for the handshake and never writes to the socket after it
+    asio::async_write(conn->socket, buffers,
+                      [conn, batch](boost::system::error_code ec, std::size_t) {
+                          if (ec) {
+                              std::cerr << "Error sending data to client " << conn->connId << ": " << ec.message() << std::endl;
+                              {
+                                  std::lock_guard<std::mutex> lock(conn->mutex);
+                                  conn->controlFrames.clear();
+                                  conn->pendingFrames.clear();
+                                  conn->queuedBytes = 0;
+                                  conn->writing = false;
+                              }
+                              WebSocketSession::handleDisconnection(conn);
+                              return;
+                          }
+                          flush(conn);
+                      });
+}
+
+void FrameWriter::pause() {
+    paused.store(true, std::memory_order_release);
+}
+
+void FrameWriter::resume() {
+    paused.store(false, std::memory_order_release);
+
+    std::vector<std::shared_ptr<SocketConnection>> connections;
+    connectionRegistry.forEach([&](const std::string&, const std::shared_ptr<SocketConnection>& conn) {
+        connections.push_back(conn);
+    });
+    for (const auto& conn : connections) {
+        {
+            std::lock_guard<std::mutex> lock(conn->mutex);
+            if (conn->writing || (conn->controlFrames.empty() && conn->pendingFrames.empty())) {
+                continue;
+            }
+            conn->writing = true;
+            conn->writeStartedAt = std::chrono::steady_clock::now();
+        }
+        asio::post(conn->socket.get_executor(), [conn] { flush(conn); });
+    }
+}
+
+bool FrameWriter::idle(const std::shared_ptr<SocketConnection>& conn) {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    return !conn->writing;
+}
+
+bool FrameWriter::stalled(const std::shared_ptr<SocketConnection>& conn, std::chrono::steady_clock::duration timeout) {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    return conn->writing && std::chrono::steady_clock::now() - conn->writeStartedAt >= timeout;
+}
@@ -0,0 +1,74 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_FRAMEWRITER_H
+#define SOCKETSERVICE_FRAMEWRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "../model/SocketConnection.h"
+
+/*
+ * Batched outbound path for all server -> client messages.
+ *
+ * A message is encoded into a complete websocket frame once (server frames are unmasked), so a single
+ * tick frame is shared by every subscriber instead of being serialized per connection. Frames queued
+ * on a connection while a write is in flight are sent together with one gather write, which is one
+ * syscall (or one io_uring submission) for the whole batch instead of one per frame.
+ *
+ * Each connection has two lanes. Control frames (heartbeats, pongs, acks, errors) are always written
+ * ahead of queued market data, so a backlog of ticks can't delay heartbeats until the client gives up.
+ *
+ * FrameWriter is the only writer on a socket once the handshake is done: client frames are decoded by
+ * FrameReader instead of Beast, whose read loop would otherwise write pongs and close replies by itself.
+ */
+class FrameWriter {
+public:
+    using Frame = std::shared_ptr<const std::string>;
+
+    enum class Lane { Control, Data };
+
+    enum class Opcode : uint8_t { Continuation = 0x0, Text = 0x1, Binary = 0x2, Close = 0x8, Ping = 0x9, Pong = 0xA };
+
+    static Frame encode(Opcode opcode, std::string_view payload);
+    static Frame text(std::string_view payload) { return encode(Opcode::Text, payload); }
+    static Opcode opcode(const Frame& frame);
+    static std::string_view payload(const Frame& frame);
+
+    // Thread safe, may be called from stream consumer and heartbeat threads
+    static void send(const std::shared_ptr<SocketConnection>& conn, Frame frame, Lane lane = Lane::Data);
+
+    // Drops queued data, writes closeFrame after any queued control frames and then closes the socket
+    static void sendClose(const std::shared_ptr<SocketConnection>& conn, Frame closeFrame);
+
+    /*
+     * While paused, frames are only queued and no new write is started, so once in-flight writes
+     * complete every socket sits on a frame boundary. Used by SocketHandoff.
+     */
+    static void pause();
+    static void resume();
+    static bool idle(const std::shared_ptr<SocketConnection>& conn);
+
+    // True if a write has been waiting on the client for at least timeout, i.e. it stopped reading
+    static bool stalled(const std::shared_ptr<SocketConnection>& conn, std::chrono::steady_clock::duration timeout);
+
+private:
+    static std::atomic<bool> paused;
+
+    // Upper bound on frames per gather write, kept under IOV_MAX
+    static constexpr size_t maxBatchFrames = 64;
+    // Data bytes per write, control frames queued meanwhile go out at most one such write later
+    static constexpr size_t dataBudgetBytes = 64 * 1024;
+    // A client this far behind is disconnected instead of being buffered for without bound
+    static constexpr size_t maxQueuedBytes = 4 * 1024 * 1024;
+
+    static void flush(const std::shared_ptr<SocketConnection>& conn);
+};
+
+#endif //SOCKETSERVICE_FRAMEWRITER_H
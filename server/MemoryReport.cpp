@@ -0,0 +1,90 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <unistd.h>
+
+#include "MemoryReport.h"
+#include "WebSocketSession.h"
+#include "../utils/GlobalMaps.h"
+
+namespace {
+
+struct StateTotals {
+    size_t connections = 0;
+    size_t bytes = 0;
+};
+
+// Heap bytes behind a std::string, short strings are stored inline
+size_t heapBytes(const std::string& s) {
+    return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+}
+
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages = 0, residentPages = 0;
+    statm >> totalPages >> residentPages;
+    return residentPages * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+void printState(const char* name, const StateTotals& totals) {
+    std::cout << "  " << std::left << std::setw(12) << name
+              << " connections=" << totals.connections
+              << " avg_bytes=" << (totals.connections ? totals.bytes / totals.connections : 0) << "\n";
+}
+
+}
+
+void MemoryReport::log() {
+    std::vector<std::shared_ptr<SocketConnection>> connections;
+    connectionRegistry.forEach([&](const std::string&, const std::shared_ptr<SocketConnection>& conn) {
+        connections.push_back(conn);
+    });
+
+    // Both objects come from make_shared, so each carries a control block of two counters
+    const size_t controlBlock = 2 * sizeof(long);
+    const size_t fixedBytes = sizeof(SocketConnection) + sizeof(WebSocketSession) + 2 * controlBlock;
+    const size_t inlineSymbols = SocketConnection::SymbolList().capacity();
+
+    StateTotals idle, subscribed, backlogged;
+    for (const auto& conn : connections) {
+        size_t bytes = fixedBytes + heapBytes(conn->connId) + conn->readBuffer.capacity() + heapBytes(conn->partialMessage);
+
+        if (conn->symbols.capacity() > inlineSymbols) {
+            bytes += conn->symbols.capacity() * sizeof(std::string);
+        }
+        for (const auto& symbol : conn->symbols) {
+            // plus this connection's slot in the symbol's subscriber list
+            bytes += heapBytes(symbol) + sizeof(std::shared_ptr<SocketConnection>);
+        }
+
+        size_t queued;
+        {
+            std::lock_guard<std::mutex> lock(conn->mutex);
+            queued = conn->controlFrames.size() + conn->pendingFrames.size();
+            // frames themselves are shared by all subscribers, only the queue slots are per connection
+            bytes += (conn->controlFrames.capacity() + conn->pendingFrames.capacity()) * sizeof(conn->pendingFrames[0]);
+        }
+
+        auto& state = queued > 0 ? backlogged : (conn->symbols.empty() ? idle : subscribed);
+        ++state.connections;
+        state.bytes += bytes;
+    }
+
+    size_t rss = residentBytes();
+    std::cout << "Memory report: " << connections.size() << " connections, RSS " << rss / 1024 << " KB";
+    if (!connections.empty()) {
+        std::cout << " (" << rss / connections.size() << " bytes per connection)";
+    }
+    std::cout << "\n";
+    printState("idle", idle);
+    printState("subscribed", subscribed);
+    printState("backlogged", backlogged);
+    std::cout << "  fixed: SocketConnection=" << sizeof(SocketConnection)
+              << " tcp::socket=" << sizeof(tcp::socket)
+              << " WebSocketSession=" << sizeof(WebSocketSession) << std::endl;
+}
@@ -0,0 +1,22 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_MEMORYREPORT_H
+#define SOCKETSERVICE_MEMORYREPORT_H
+
+/*
+ * Estimates the memory held per connection, grouped by connection state:
+ *   idle       - open but not subscribed to anything
+ *   subscribed - receiving ticks with nothing queued
+ *   backlogged - frames queued behind a slow socket
+ * Counts the objects the service allocates per client; kernel socket buffers are not included, the
+ * process RSS per connection is logged next to it for comparison. Triggered with SIGUSR1.
+ */
+class MemoryReport {
+public:
+    // Must run on the io thread, which owns the per connection buffers
+    static void log();
+};
+
+#endif //SOCKETSERVICE_MEMORYREPORT_H
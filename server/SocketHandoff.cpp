@@ -0,0 +1,465 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#include <iostream>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <boost/json.hpp>
+
+#include "SocketHandoff.h"
+#include "WebSocketSession.h"
+#include "FrameWriter.h"
+#include "../utils/GlobalMaps.h"
+#include "../model/ClientRequest.h"
+#include "../redisHandler/RedisConsumer.h"
+
+std::unique_ptr<asio::local::stream_protocol::acceptor> SocketHandoff::acceptor;
+
+void SocketHandoff::listen(asio::io_context& ioc, WebSocketServer& server, const std::string& path) {
+    // A stale path is left behind by the predecessor (or a crash), so it is always replaced
+    ::unlink(path.c_str());
+
+    boost::system::error_code ec;
+    acceptor = std::make_unique<asio::local::stream_protocol::acceptor>(ioc);
+    acceptor->open(asio::local::stream_protocol(), ec);
+    if (!ec) acceptor->bind(asio::local::stream_protocol::endpoint(path), ec);
+    if (!ec) acceptor->listen(asio::socket_base::max_listen_connections, ec);
+    if (ec) {
+        std::cerr << "Handoff socket " << path << " unavailable: " << ec.message() << std::endl;
+        acceptor.reset();
+        return;
+    }
+
+    std::cout << "Waiting for a successor process on " << path << std::endl;
+    acceptSuccessor(server);
+}
+
+void SocketHandoff::acceptSuccessor(WebSocketServer& server) {
+    acceptor->async_accept([&server](boost::system::error_code ec, asio::local::stream_protocol::socket socket) {
+        if (!ec && !sameUser(socket.native_handle())) {
+            std::cerr << "Rejected a handoff request from another user.\n";
+        } else if (!ec) {
+            std::cout << "Successor process connected, draining in-flight writes...\n";
+            auto peer = std::make_shared<asio::local::stream_protocol::socket>(std::move(socket));
+            peer->non_blocking(false, ec);
+            FrameWriter::pause();
+            awaitIdleWrites(server, peer, std::chrono::steady_clock::now() + std::chrono::seconds(2));
+            return;
+        }
+        acceptSuccessor(server);
+    });
+}
+
+void SocketHandoff::awaitIdleWrites(WebSocketServer& server,
+                                    std::shared_ptr<asio::local::stream_protocol::socket> peer,
+                                    std::chrono::steady_clock::time_point deadline) {
+    // A write cut short by the handoff would leave half a frame on the wire, so wait for all of them
+    std::vector<std::shared_ptr<SocketConnection>> writing;
+    connectionRegistry.forEach([&](const std::string&, const std::shared_ptr<SocketConnection>& conn) {
+        if (!FrameWriter::idle(conn)) writing.push_back(conn);
+    });
+
+    if (!writing.empty() && std::chrono::steady_clock::now() < deadline) {
+        auto timer = std::make_shared<asio::steady_timer>(peer->get_executor(), std::chrono::milliseconds(10));
+        timer->async_wait([&server, peer, deadline, timer](boost::system::error_code) {
+            awaitIdleWrites(server, peer, deadline);
+        });
+        return;
+    }
+
+    // A client still mid-write by now is too slow to wait for, so it is dropped instead of handed over
+    if (!writing.empty()) {
+        std::cerr << "Disconnecting " << writing.size() << " clients whose writes did not drain in time.\n";
+        for (const auto& conn : writing) {
+            WebSocketSession::handleDisconnection(conn);
+        }
+    }
+
+    // Only returns if the handoff failed, in which case this process keeps serving
+    handOff(server, peer->native_handle());
+    FrameWriter::resume();
+    acceptSuccessor(server);
+}
+
+void SocketHandoff::handOff(WebSocketServer& server, int peerFd) {
+    std::vector<std::shared_ptr<SocketConnection>> connections;
+    connectionRegistry.forEach([&](const std::string&, const std::shared_ptr<SocketConnection>& conn) {
+        connections.push_back(conn);
+    });
+
+    /*
+     * Writes are paused and drained, and holding every connection mutex stops new frames from being
+     * queued while the state is exported. Running on the io thread keeps reads from progressing too.
+     */
+    std::vector<std::unique_lock<std::mutex>> writeLocks;
+    writeLocks.reserve(connections.size());
+    for (const auto& conn : connections) {
+        writeLocks.emplace_back(conn->mutex);
+    }
+
+    bool ok = sendFrame(peerFd, boost::json::serialize(boost::json::object{{"type", "listener"}}), server.nativeHandle());
+
+    std::vector<std::string> activeStreams;
+    streamStatusMap.forEach([&](const std::string& symbol, bool active) {
+        if (active) activeStreams.push_back(symbol);
+    });
+    for (const auto& symbol : activeStreams) {
+        if (!ok) break;
+        // A stream that has not broadcast anything yet resumes from the latest entry
+        std::string lastId = streamOffsetMap.find(symbol).value_or("$");
+        ok = sendFrame(peerFd, boost::json::serialize(boost::json::object{
+                {"type", "stream"}, {"symbol", symbol}, {"lastId", lastId}}));
+    }
+
+    // connId -> view for every symbol, built in one pass so each lookup below is constant time
+    std::unordered_map<std::string, std::unordered_map<std::string, std::shared_ptr<const SubscriptionView>>> views;
+    symbolConnectionMap.forEach([&](const std::string& symbol, const std::vector<SubscriberGroup>& groups) {
+        auto& byConn = views[symbol];
+        for (const auto& group : groups) {
+            for (const auto& conn : group.connections) {
+                byConn.emplace(conn->connId, group.view);
+            }
+        }
+    });
+    const SubscriptionView defaultView;
+
+    for (const auto& conn : connections) {
+        if (!ok) break;
+        if (conn->closing) {
+            continue;  // its close frame is queued, dropped when this process exits
+        }
+        boost::json::array symbols;
+        for (const auto& symbol : conn->symbols) {
+            const SubscriptionView* view = &defaultView;
+            if (auto bySymbol = views.find(symbol); bySymbol != views.end()) {
+                if (auto it = bySymbol->second.find(conn->connId); it != bySymbol->second.end()) {
+                    view = it->second.get();
+                }
+            }
+            boost::json::array fields;
+            for (const auto& field : view->fields) {
+                fields.emplace_back(boost::json::string_view(field.data(), field.size()));
+            }
+            symbols.emplace_back(boost::json::object{{"symbol", symbol}, {"fields", fields}, {"maxRate", view->maxRate}});
+        }
+        // Frames queued while writes were paused are re-sent by the successor on the same lanes
+        boost::json::array control, pending;
+        for (const auto& frame : conn->controlFrames) {
+            control.push_back(exportFrame(frame));
+        }
+        for (const auto& frame : conn->pendingFrames) {
+            pending.push_back(exportFrame(frame));
+        }
+        ok = sendFrame(peerFd, boost::json::serialize(boost::json::object{
+                {"type", "session"}, {"connId", conn->connId}, {"symbols", symbols},
+                {"control", control}, {"pending", pending}}),
+                conn->socket.native_handle());
+    }
+
+    if (ok) {
+        ok = sendFrame(peerFd, boost::json::serialize(boost::json::object{{"type", "done"}}));
+    }
+
+    if (!ok) {
+        // The successor only adopts anything once it sees "done", so this process still owns every socket
+        std::cerr << "Handoff failed, continuing to serve " << connections.size() << " connections.\n";
+        return;
+    }
+
+    // The ack is the commit point. Without it the successor is told to drop everything, and this process
+    // keeps serving once the write locks are released and writes resume
+    timeval timeout{5, 0};
+    ::setsockopt(peerFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string reply;
+    int unusedFd = -1;
+    if (!recvFrame(peerFd, reply, unusedFd) || reply != R"({"type":"ack"})") {
+        if (unusedFd >= 0) ::close(unusedFd);
+        sendFrame(peerFd, boost::json::serialize(boost::json::object{{"type", "abort"}}));
+        std::cerr << "No ack from successor, continuing to serve " << connections.size() << " connections.\n";
+        return;
+    }
+
+    /*
+     * The successor owns duplicates of every socket now. Exiting without running destructors ensures
+     * nothing in this process sends a close frame or FIN; the write locks stay held until then.
+     */
+    std::cout << "Handed off " << connections.size() << " connections, exiting." << std::endl;
+    std::fflush(nullptr);  // _Exit skips stdio flushing, e.g. a stream capture being recorded
+    std::_Exit(0);
+}
+
+bool SocketHandoff::sameUser(int peerFd) {
+    ucred cred{};
+    socklen_t length = sizeof(cred);
+    return ::getsockopt(peerFd, SOL_SOCKET, SO_PEERCRED, &cred, &length) == 0 && cred.uid == ::geteuid();
+}
+
+void SocketHandoff::stop() {
+    acceptor.reset();
+}
+
+int SocketHandoff::takeover(asio::io_context& ioc, const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "No running process to take over at " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+
+    /*
+     * Nothing is adopted until "done" arrives. Until then the predecessor keeps serving if anything
+     * goes wrong, so on failure every received descriptor is closed again (closing a duplicate does
+     * not affect the predecessor's copy) and no session or consumer is started.
+     */
+    struct AdoptedSession {
+        std::string connId;
+        int fd;
+        std::vector<std::pair<std::string, SubscriptionView>> subscriptions;
+        std::vector<FrameWriter::Frame> control;
+        std::vector<FrameWriter::Frame> pending;
+    };
+    int listenerFd = -1;
+    std::vector<AdoptedSession> sessions;
+    std::vector<std::pair<std::string, std::string>> streams;
+    bool done = false;
+
+    while (!done) {
+        std::string payload;
+        int passedFd = -1;
+        if (!recvFrame(fd, payload, passedFd)) {
+            std::cerr << "Handoff interrupted after " << sessions.size() << " connections.\n";
+            if (passedFd >= 0) ::close(passedFd);
+            break;
+        }
+
+        boost::json::value parsed;
+        try {
+            parsed = boost::json::parse(payload);
+        } catch (...) {
+            std::cerr << "Invalid handoff message: " << payload << std::endl;
+            if (passedFd >= 0) ::close(passedFd);
+            continue;
+        }
+        if (!parsed.is_object() || !parsed.as_object().contains("type")) {
+            if (passedFd >= 0) ::close(passedFd);
+            continue;
+        }
+        // A message missing a field or carrying one of the wrong type throws, which fails the whole handoff
+        bool failed = false;
+        try {
+            const auto& obj = parsed.as_object();
+            std::string type = obj.at("type").as_string().c_str();
+
+            if (type == "listener") {
+                listenerFd = std::exchange(passedFd, -1);
+            } else if (type == "stream") {
+                streams.emplace_back(obj.at("symbol").as_string().c_str(), obj.at("lastId").as_string().c_str());
+            } else if (type == "session" && passedFd >= 0) {
+                AdoptedSession session{obj.at("connId").as_string().c_str(), passedFd, {}, {}, {}};
+                for (const auto& val : obj.at("symbols").as_array()) {
+                    // parsed like a client subscribe request, so a plain symbol string also works
+                    if (val.is_string()) {
+                        session.subscriptions.emplace_back(val.as_string().c_str(), SubscriptionView());
+                    } else {
+                        ClientRequest request(val);
+                        session.subscriptions.emplace_back(val.as_object().at("symbol").as_string().c_str(),
+                                                           SubscriptionView(request.fields, request.maxRate));
+                    }
+                }
+                for (auto [name, frames] : {std::pair{"control", &session.control}, std::pair{"pending", &session.pending}}) {
+                    if (const auto* list = obj.if_contains(name); list && list->is_array()) {
+                        for (const auto& frame : list->as_array()) {
+                            if (auto imported = importFrame(frame)) frames->push_back(std::move(imported));
+                        }
+                    }
+                }
+                sessions.push_back(std::move(session));
+                passedFd = -1;
+            } else if (type == "done") {
+                done = listenerFd >= 0;
+                if (!done) {
+                    std::cerr << "Handoff finished without a listening socket.\n";
+                    failed = true;
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Malformed handoff message after " << sessions.size() << " connections: " << e.what() << std::endl;
+            failed = true;
+        }
+        // a descriptor that came with a message nothing took it from
+        if (passedFd >= 0) ::close(passedFd);
+        if (failed) break;
+    }
+
+    if (done) {
+        // The predecessor exits once it has the ack, which closes this socket. A message instead means it
+        // gave up waiting and keeps serving, so nothing may be adopted
+        sendFrame(fd, boost::json::serialize(boost::json::object{{"type", "ack"}}));
+        std::string reply;
+        int unusedFd = -1;
+        if (recvFrame(fd, reply, unusedFd)) {
+            std::cerr << "Predecessor aborted the handoff: " << reply << std::endl;
+            if (unusedFd >= 0) ::close(unusedFd);
+            done = false;
+        }
+    }
+
+    ::close(fd);
+    if (!done) {
+        if (listenerFd >= 0) ::close(listenerFd);
+        for (const auto& session : sessions) {
+            ::close(session.fd);
+        }
+        return -1;
+    }
+
+    // Marking the streams active first stops resumed sessions from starting a second consumer
+    for (const auto& [symbol, lastId] : streams) {
+        streamStatusMap.insert(symbol, true);
+    }
+
+    size_t sessionCount = 0;
+    for (auto& adopted : sessions) {
+        boost::system::error_code ec;
+        tcp::socket socket(ioc);
+        socket.assign(tcp::v4(), adopted.fd, ec);
+        if (ec) {
+            std::cerr << "Failed to adopt client socket: " << ec.message() << std::endl;
+            ::close(adopted.fd);
+            continue;
+        }
+        auto session = std::make_shared<WebSocketSession>(adopted.connId, std::move(socket));
+        session->resume(adopted.subscriptions);
+
+        // Frames queued while writes were paused go out ahead of any new tick, each on its own lane
+        if (auto conn = connectionRegistry.find(adopted.connId)) {
+            for (auto& frame : adopted.control) {
+                FrameWriter::send(conn.value(), std::move(frame), FrameWriter::Lane::Control);
+            }
+            for (auto& frame : adopted.pending) {
+                FrameWriter::send(conn.value(), std::move(frame));
+            }
+        }
+        ++sessionCount;
+    }
+    std::cout << "Took over " << sessionCount << " connections and " << streams.size() << " streams.\n";
+
+    // Consumers start once every session is subscribed, otherwise they would find no one to broadcast to
+    for (const auto& [symbol, lastId] : streams) {
+        std::thread([symbol, lastId]() {
+            RedisConsumer::consumeStream(symbol, lastId);
+        }).detach();
+    }
+
+    return listenerFd;
+}
+
+boost::json::value SocketHandoff::exportFrame(const FrameWriter::Frame& frame) {
+    auto payload = FrameWriter::payload(frame);
+    auto opcode = FrameWriter::opcode(frame);
+    if (opcode == FrameWriter::Opcode::Text) {
+        return boost::json::string_view(payload.data(), payload.size());
+    }
+    // pong payloads are arbitrary bytes, which a JSON string can't carry
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(payload.size() * 2);
+    for (unsigned char byte : payload) {
+        hex.push_back(digits[byte >> 4]);
+        hex.push_back(digits[byte & 0x0F]);
+    }
+    return boost::json::object{{"opcode", static_cast<int>(opcode)}, {"hex", hex}};
+}
+
+FrameWriter::Frame SocketHandoff::importFrame(const boost::json::value& value) {
+    if (value.is_string()) {
+        return FrameWriter::text(value.as_string().c_str());
+    }
+    const auto* obj = value.if_object();
+    if (!obj || !obj->contains("opcode") || !obj->contains("hex") || !obj->at("hex").is_string()) {
+        return nullptr;
+    }
+    std::string hex = obj->at("hex").as_string().c_str();
+    std::string payload;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        payload.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    }
+    return FrameWriter::encode(static_cast<FrameWriter::Opcode>(obj->at("opcode").to_number<int>()), payload);
+}
+
+bool SocketHandoff::sendFrame(int fd, const std::string& payload, int passFd) {
+    auto length = static_cast<uint32_t>(payload.size());
+    iovec iov[2] = {{&length, sizeof(length)}, {const_cast<char*>(payload.data()), payload.size()}};
+
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    if (passFd >= 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &passFd, sizeof(int));
+    }
+
+    ssize_t sent = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (sent < 0) {
+        std::cerr << "Handoff send failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // The descriptor travels with the first byte, anything left over is plain data
+    size_t total = sizeof(length) + payload.size();
+    while (static_cast<size_t>(sent) < total) {
+        size_t offset = sent - sizeof(length);
+        ssize_t n = ::send(fd, payload.data() + offset, payload.size() - offset, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+bool SocketHandoff::recvFrame(int fd, std::string& payload, int& passedFd) {
+    uint32_t length = 0;
+    iovec iov{&length, sizeof(length)};
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    passedFd = -1;
+    if (::recvmsg(fd, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC) != sizeof(length)) {
+        return false;
+    }
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            std::memcpy(&passedFd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    payload.resize(length);
+    size_t received = 0;
+    while (received < length) {
+        ssize_t n = ::recv(fd, payload.data() + received, length - received, 0);
+        if (n <= 0) return false;
+        received += n;
+    }
+    return true;
+}
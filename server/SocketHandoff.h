@@ -0,0 +1,68 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_SOCKETHANDOFF_H
+#define SOCKETSERVICE_SOCKETHANDOFF_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/json.hpp>
+
+#include "WebSocketServer.h"
+#include "FrameWriter.h"
+
+namespace asio = boost::asio;
+
+/*
+ * Zero-downtime restart. The running process listens on a unix domain socket; a new process started
+ * with --takeover connects to it and receives, via SCM_RIGHTS, the listening socket and every client
+ * socket along with its subscribed symbols and the stream ID to resume each symbol from (see
+ * SymbolBroadcaster::resumeOffset).
+ *
+ * Each message on the handoff socket is a 4 byte length followed by a JSON payload, optionally carrying
+ * one file descriptor:
+ *   {"type":"listener"}                                 + listening socket
+ *   {"type":"stream","symbol":...,"lastId":...}
+ *   {"type":"session","connId":...,"symbols":[{"symbol":...,"fields":[...],"maxRate":...}],
+ *    "control":[...],"pending":[...]}                   + client socket
+ * control and pending are the frames still queued on the connection's two lanes, each frame as its
+ * text payload, or {"opcode":...,"hex":...} for other frames such as pongs.
+ *   {"type":"done"}
+ * The handoff is all or nothing, and the new process's {"type":"ack"} is the commit point. Once the old
+ * process reads it, it exits without closing any client connection, and the new process adopts everything
+ * when it sees the handoff socket close. If the ack does not arrive in time, the old process answers
+ * {"type":"abort"} and keeps serving, and the new process drops every received descriptor, as it also does
+ * when the stream breaks off before "done". Only a process of the same user may take over.
+ */
+class SocketHandoff {
+public:
+    // Old process: waits for a successor on path and hands the server over once one connects
+    static void listen(asio::io_context& ioc, WebSocketServer& server, const std::string& path);
+
+    // New process: adopts everything from the process listening on path, returns the listening socket or -1
+    static int takeover(asio::io_context& ioc, const std::string& path);
+
+    // Stops waiting for a successor, before the io_context goes away
+    static void stop();
+
+private:
+    static std::unique_ptr<asio::local::stream_protocol::acceptor> acceptor;
+
+    static void acceptSuccessor(WebSocketServer& server);
+    static void awaitIdleWrites(WebSocketServer& server,
+                                std::shared_ptr<asio::local::stream_protocol::socket> peer,
+                                std::chrono::steady_clock::time_point deadline);
+    static void handOff(WebSocketServer& server, int peerFd);
+    static bool sameUser(int peerFd);
+
+    static boost::json::value exportFrame(const FrameWriter::Frame& frame);
+    static FrameWriter::Frame importFrame(const boost::json::value& value);
+
+    static bool sendFrame(int fd, const std::string& payload, int passFd = -1);
+    static bool recvFrame(int fd, std::string& payload, int& passedFd);
+};
+
+#endif //SOCKETSERVICE_SOCKETHANDOFF_H
@@ -0,0 +1,153 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#include <algorithm>
+
+#include "SymbolBroadcaster.h"
+#include "FrameWriter.h"
+#include "../utils/GlobalMaps.h"
+
+bool SymbolBroadcaster::publish(const boost::json::value& data, const std::string& id) {
+    lastId_ = id;
+    auto groupsOpt = symbolConnectionMap.find(symbol_);
+    if (!groupsOpt) {
+        throttles_.clear();
+        return false;
+    }
+    const auto& groups = groupsOpt.value();
+    auto now = std::chrono::steady_clock::now();
+
+    for (const auto& group : groups) {
+        const auto& view = *group.view;
+        if (view.maxRate == 0) {
+            send(group, data);
+            continue;
+        }
+
+        auto& throttle = throttles_[view.key()];
+        throttle.interval = std::chrono::nanoseconds(1'000'000'000 / view.maxRate);
+        if (!throttle.hasPending && now - throttle.lastSent >= throttle.interval) {
+            send(group, data);
+            throttle.lastSent = now;
+        } else if (throttle.hasPending && throttle.pending.is_object() && data.is_object()) {
+            auto& pending = throttle.pending.as_object();
+            for (const auto& field : data.as_object()) {
+                pending[field.key()] = field.value();
+            }
+        } else {
+            if (!throttle.hasPending) throttle.pendingFrom = id;
+            throttle.pending = data;
+            throttle.hasPending = true;
+        }
+    }
+
+    forgetUnusedViews(groups);
+    return true;
+}
+
+void SymbolBroadcaster::flushDue() {
+    if (std::none_of(throttles_.begin(), throttles_.end(), [](const auto& entry) { return entry.second.hasPending; })) {
+        return;
+    }
+
+    auto groupsOpt = symbolConnectionMap.find(symbol_);
+    if (!groupsOpt) {
+        throttles_.clear();
+        return;
+    }
+    forgetUnusedViews(groupsOpt.value());
+    auto now = std::chrono::steady_clock::now();
+
+    for (const auto& group : groupsOpt.value()) {
+        auto it = throttles_.find(group.view->key());
+        if (it == throttles_.end()) continue;
+
+        auto& throttle = it->second;
+        if (throttle.hasPending && now - throttle.lastSent >= throttle.interval) {
+            send(group, throttle.pending);
+            throttle.pending = nullptr;
+            throttle.pendingFrom.clear();
+            throttle.hasPending = false;
+            throttle.lastSent = now;
+        }
+    }
+}
+
+std::optional<std::chrono::milliseconds> SymbolBroadcaster::nextDue() const {
+    std::optional<std::chrono::steady_clock::time_point> earliest;
+    for (const auto& [key, throttle] : throttles_) {
+        if (throttle.hasPending) {
+            auto due = throttle.lastSent + throttle.interval;
+            if (!earliest || due < *earliest) earliest = due;
+        }
+    }
+    if (!earliest) {
+        return std::nullopt;
+    }
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*earliest - std::chrono::steady_clock::now());
+    return std::max(remaining, std::chrono::milliseconds(0));
+}
+
+std::optional<std::string> SymbolBroadcaster::resumeOffset() const {
+    const std::string* oldest = nullptr;
+    for (const auto& [key, throttle] : throttles_) {
+        if (throttle.hasPending && (!oldest || parseId(throttle.pendingFrom) < parseId(*oldest))) {
+            oldest = &throttle.pendingFrom;
+        }
+    }
+    if (oldest) {
+        return previousId(*oldest);  // reads are exclusive of the given ID
+    }
+    if (lastId_.empty()) {
+        return std::nullopt;
+    }
+    return lastId_;
+}
+
+void SymbolBroadcaster::forgetUnusedViews(const std::vector<SubscriberGroup>& groups) {
+    // A view whose last subscriber left drops its pending tick too
+    for (auto it = throttles_.begin(); it != throttles_.end();) {
+        bool live = std::any_of(groups.begin(), groups.end(),
+                                [&](const SubscriberGroup& group) { return group.view->key() == it->first; });
+        it = live ? std::next(it) : throttles_.erase(it);
+    }
+}
+
+void SymbolBroadcaster::send(const SubscriberGroup& group, const boost::json::value& data) {
+    boost::json::object clientData;
+    clientData["data"] = group.view->project(data);
+    clientData["type"] = "marketfeed";
+
+    /*
+     * Serialized and framed once per view and the same buffer is queued on every subscriber in it.
+     * Writes then happen on the io thread in batches, so a slow client only grows its own queue
+     * (up to FrameWriter's cap, then it is disconnected) and never holds up the broadcast to the others.
+     */
+    auto frame = FrameWriter::text(boost::json::serialize(clientData));
+    for (const auto& conn : group.connections) {
+        FrameWriter::send(conn, frame);
+    }
+}
+
+std::pair<uint64_t, uint64_t> SymbolBroadcaster::parseId(const std::string& id) {
+    auto dash = id.find('-');
+    try {
+        uint64_t ms = std::stoull(id.substr(0, dash));
+        uint64_t seq = dash == std::string::npos ? 0 : std::stoull(id.substr(dash + 1));
+        return {ms, seq};
+    } catch (const std::exception&) {
+        return {0, 0};
+    }
+}
+
+std::string SymbolBroadcaster::previousId(const std::string& id) {
+    auto [ms, seq] = parseId(id);
+    if (seq > 0) {
+        return std::to_string(ms) + '-' + std::to_string(seq - 1);
+    }
+    if (ms > 0) {
+        return std::to_string(ms - 1) + '-' + std::to_string(UINT64_MAX);
+    }
+    return "0-0";
+}
@@ -0,0 +1,68 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_SYMBOLBROADCASTER_H
+#define SOCKETSERVICE_SYMBOLBROADCASTER_H
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <boost/json.hpp>
+
+#include "../model/SubscriptionView.h"
+
+/*
+ * Fans a symbol's ticks out to its subscriber groups. Each distinct view gets its frame projected,
+ * serialized and encoded once per tick, and that frame is shared by every connection in the group.
+ *
+ * Rate-limited views are conflated: ticks arriving inside the view's interval are merged (newer
+ * fields overwrite older ones) and the merged tick goes out once the interval has passed.
+ *
+ * One instance per stream consumer, not thread safe.
+ */
+class SymbolBroadcaster {
+public:
+    explicit SymbolBroadcaster(std::string symbol) : symbol_(std::move(symbol)) {}
+
+    // id is the tick's stream entry ID. Returns false when nobody is subscribed to the symbol any more
+    bool publish(const boost::json::value& data, const std::string& id);
+
+    // Sends the conflated ticks whose interval has passed
+    void flushDue();
+
+    // Time until the next conflated tick is due, nullopt when nothing is pending
+    std::optional<std::chrono::milliseconds> nextDue() const;
+
+    /*
+     * The stream ID to read on from so that no tick is lost: the entry before the oldest tick still
+     * held back by conflation, else the last published entry. nullopt before anything was published.
+     * Resuming from it may repeat some ticks to full-rate views, but never skips a conflated one.
+     */
+    std::optional<std::string> resumeOffset() const;
+
+private:
+    struct Throttle {
+        std::chrono::steady_clock::duration interval{};
+        std::chrono::steady_clock::time_point lastSent{};
+        boost::json::value pending;
+        std::string pendingFrom;   // ID of the oldest tick merged into pending
+        bool hasPending = false;
+    };
+
+    std::string symbol_;
+    std::unordered_map<std::string, Throttle> throttles_;   // view key -> conflation state
+    std::string lastId_;
+
+    void forgetUnusedViews(const std::vector<SubscriberGroup>& groups);
+    static void send(const SubscriberGroup& group, const boost::json::value& data);
+
+    // Stream IDs are "<ms>-<seq>"
+    static std::pair<uint64_t, uint64_t> parseId(const std::string& id);
+    static std::string previousId(const std::string& id);
+};
+
+#endif //SOCKETSERVICE_SYMBOLBROADCASTER_H
@@ -2,6 +2,8 @@
 // Created by Satyam Saurabh on 24/02/25.
 //
 #include <iostream>
+#include <atomic>
+#include <unistd.h>
 
 #include "WebSocketServer.h"
 #include "WebSocketSession.h"
@@ -9,6 +11,19 @@
 WebSocketServer::WebSocketServer(asio::io_context& ioc, short port)
         : acceptor_(ioc, tcp::endpoint(tcp::v4(), port)) {}
 
+WebSocketServer::WebSocketServer(tcp::acceptor acceptor)
+        : acceptor_(std::move(acceptor)) {}
+
+std::unique_ptr<WebSocketServer> WebSocketServer::fromListener(asio::io_context& ioc, tcp::acceptor::native_handle_type listenerFd) {
+    return std::unique_ptr<WebSocketServer>(new WebSocketServer(tcp::acceptor(ioc, tcp::v4(), listenerFd)));
+}
+
+std::string WebSocketServer::nextConnectionId() {
+    // pid prefix keeps ids unique across processes, since connections survive a handoff
+    static std::atomic<uint64_t> counter{0};
+    return std::to_string(::getpid()) + "-" + std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+}
+
 void WebSocketServer::start() {
     acceptConnection();
 }
@@ -33,8 +48,8 @@ void WebSocketServer::handleRequest(tcp::socket socket) {
     http::async_read(*socket_ptr, *buffer, *req, [this, socket_ptr, buffer, req](boost::system::error_code ec, std::size_t) {
         if (!ec) {
             if (req->target() == "/cpp/ws" && req->method() == http::verb::get) {
-                auto session = std::make_shared<WebSocketSession>(std::move(*socket_ptr));
-                session->start();
+                auto session = std::make_shared<WebSocketSession>(nextConnectionId(), std::move(*socket_ptr));
+                session->start(std::move(*req));
             } else {
                 http::response<http::string_body> res(http::status::not_found, req->version());
                 res.set(http::field::server, "Boost.Beast WebSocket Server");
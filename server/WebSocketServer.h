@@ -7,6 +7,8 @@
 
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
+#include <memory>
+#include <string>
 
 namespace asio = boost::asio;
 namespace beast = boost::beast;
@@ -17,11 +19,19 @@ using tcp = asio::ip::tcp;
 class WebSocketServer {
 public:
     WebSocketServer(asio::io_context& ioc, short port);
+    // Adopts a listening socket inherited from a previous process
+    static std::unique_ptr<WebSocketServer> fromListener(asio::io_context& ioc, tcp::acceptor::native_handle_type listenerFd);
     void start();
 
+    tcp::acceptor::native_handle_type nativeHandle() { return acceptor_.native_handle(); }
+
+    static std::string nextConnectionId();
+
 private:
     tcp::acceptor acceptor_;
 
+    explicit WebSocketServer(tcp::acceptor acceptor);
+
     void acceptConnection();
     void handleRequest(tcp::socket socket);
 };
@@ -6,143 +6,263 @@
 #include "../utils/GlobalMaps.h"
 #include "../redisHandler/RedisConsumer.h"
 #include "../model/ClientRequest.h"
+#include "FrameWriter.h"
 
 #include <iostream>
 #include <boost/json.hpp>
 
-WebSocketSession::WebSocketSession(tcp::socket socket)
-        : ws_(std::move(socket)),
-          connection_(std::make_shared<SocketConnection>("default_id", std::make_shared<websocket::stream<tcp::socket>>(std::move(ws_)))) {}
-
-void WebSocketSession::start() {
-    ws_.async_accept([self = shared_from_this()](boost::system::error_code ec) {
+WebSocketSession::WebSocketSession(std::string connId, tcp::socket socket)
+        : connection_(std::make_shared<SocketConnection>(std::move(connId), std::move(socket))) {}
+
+void WebSocketSession::start(http::request<http::string_body> req) {
+    /*
+     * Beast is only needed for the upgrade. Its stream keeps about 3 KB on the heap (read buffer, timer,
+     * saved handlers), so the socket is moved back out of it once the handshake is done.
+     */
+    auto request = std::make_shared<http::request<http::string_body>>(std::move(req));
+    auto ws = std::make_shared<websocket::stream<tcp::socket>>(std::move(connection_->socket));
+    ws->async_accept(*request, [self = shared_from_this(), request, ws](boost::system::error_code ec) {
         if (!ec) {
+            self->connection_->socket = std::move(ws->next_layer());
             std::cout << "WebSocket session started!" << std::endl;
-            // Start heartbeat mechanism once when the connection is established on a separate thread
-            std::thread(&WebSocketSession::manageHeartbeat, self).detach();
-            self->readMessage();
+            self->onOpen();
         }
     });
 }
 
-void WebSocketSession::readMessage() {
-    auto buffer = std::make_shared<boost::beast::flat_buffer>();
-    ws_.async_read(*buffer, [self = shared_from_this(), buffer, this](boost::system::error_code ec, std::size_t) {
-        if (!ec) {
-            std::string msg = boost::beast::buffers_to_string(buffer->data());
-            self->handleMessage(msg);
+void WebSocketSession::resume(const std::vector<std::pair<std::string, SubscriptionView>>& subscriptions) {
+    // The client finished its handshake with the previous process, so there is no websocket stream to set up
+    std::cout << "WebSocket session resumed: " << connection_->connId << std::endl;
+    for (const auto& [symbol, view] : subscriptions) {
+        subscribe({symbol}, view);
+    }
+    onOpen();
+}
 
-            // Update atomic heartbeat timestamp and notify waiting thread
-            self->lastHeartbeatReceived.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
-            self->heartbeatCV.notify_one();
+void WebSocketSession::onOpen() {
+    connectionRegistry.insert(connection_->connId, connection_);
+    connection_->lastMessageAt = std::chrono::steady_clock::now();
+    scheduleHeartbeat();
+    readMessage();
+}
 
-            self->readMessage(); // continue reading message
-        } else {
+void WebSocketSession::readMessage(size_t minBytes) {
+    auto& buffer = connection_->readBuffer;
+    connection_->socket.async_read_some(buffer.prepare(std::max(minBytes, idleBufferBytes)),
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t bytes) {
+        if (ec) {
             std::cout << "WebSocket read error: " << ec.message() << "\n";
-            WebSocketSession::handleDisconnection(connection_);  // Cleanup on error or disconnect
+            WebSocketSession::handleDisconnection(self->connection_);  // Cleanup on error or disconnect
+            return;
+        }
+        auto& buffer = self->connection_->readBuffer;
+        buffer.commit(bytes);
+
+        size_t bytesNeeded = 0;
+        if (!self->readFrames(bytesNeeded)) {
+            return;  // closing, FrameWriter disconnects once the close frame is written
         }
+        // Most connections go quiet after subscribing, so don't keep a grown buffer around
+        if (buffer.size() == 0 && buffer.capacity() > idleBufferBytes) {
+            buffer.shrink_to_fit();
+        }
+        self->readMessage(bytesNeeded); // continue reading message
     });
 }
 
+bool WebSocketSession::readFrames(size_t& bytesNeeded) {
+    auto& buffer = connection_->readBuffer;
+    while (true) {
+        auto data = buffer.data();
+        FrameReader::Frame frame{};
+        size_t frameSize = 0;
+        auto status = FrameReader::parse(static_cast<char*>(data.data()), data.size(), maxMessageBytes, frame, frameSize);
+
+        if (status == FrameReader::Status::Incomplete) {
+            bytesNeeded = frameSize > data.size() ? frameSize - data.size() : 0;
+            return true;
+        }
+        if (status != FrameReader::Status::Complete) {
+            close(status == FrameReader::Status::TooBig ? 1009 : 1002);
+            return false;
+        }
+
+        connection_->lastMessageAt = std::chrono::steady_clock::now();
+        bool open = handleFrame(frame);
+        buffer.consume(frameSize);
+        if (!open) {
+            return false;
+        }
+    }
+}
+
+bool WebSocketSession::handleFrame(const FrameReader::Frame& frame) {
+    using Opcode = FrameWriter::Opcode;
+    auto& partial = connection_->partialMessage;
+
+    switch (frame.opcode) {
+        case Opcode::Text:
+        case Opcode::Binary:
+            if (connection_->fragmented) {
+                close(1002);
+                return false;
+            }
+            if (frame.fin) {
+                handleMessage(std::string(frame.payload));
+            } else {
+                partial.assign(frame.payload);
+                connection_->fragmented = true;
+            }
+            return true;
+
+        case Opcode::Continuation:
+            if (!connection_->fragmented) {
+                close(1002);
+                return false;
+            }
+            // Client messages are small subscribe/unsubscribe requests, anything bigger is not worth buffering
+            if (partial.size() + frame.payload.size() > maxMessageBytes) {
+                close(1009);
+                return false;
+            }
+            partial.append(frame.payload);
+            if (frame.fin) {
+                std::string message = std::move(partial);
+                partial = std::string();
+                connection_->fragmented = false;
+                handleMessage(message);
+            }
+            return true;
+
+        case Opcode::Ping:
+            FrameWriter::send(connection_, FrameWriter::encode(Opcode::Pong, frame.payload), FrameWriter::Lane::Control);
+            return true;
+
+        case Opcode::Close:
+            // echo the client's status code, if any
+            FrameWriter::sendClose(connection_, FrameWriter::encode(Opcode::Close, frame.payload.substr(0, 2)));
+            return false;
+
+        default:  // unsolicited pong
+            return true;
+    }
+}
+
+void WebSocketSession::close(uint16_t code) {
+    const char status[2] = {static_cast<char>(code >> 8), static_cast<char>(code & 0xFF)};
+    FrameWriter::sendClose(connection_, FrameWriter::encode(FrameWriter::Opcode::Close, std::string_view(status, 2)));
+}
+
 void WebSocketSession::handleMessage(const std::string& message) {
     boost::json::value parsed;
     try {
         parsed = boost::json::parse(message);
     } catch (...) {
-        ws_.async_write(boost::asio::buffer("Invalid JSON format"), [](boost::system::error_code, std::size_t) {});
+        sendControl("Invalid JSON format");
         return;
     }
     ClientRequest request(parsed);
 
     if (request.userId.empty()) {
-        ws_.async_write(boost::asio::buffer("Missing userId"), [](boost::system::error_code, std::size_t) {});
+        sendControl("Missing userId");
         return;
     }
 
     if (request.action == "subscribe") {
-        subscribe(request.value);
+        subscribe(request.value, SubscriptionView(request.fields, request.maxRate));
+        sendControl(boost::json::serialize(boost::json::object{{"type", "subscribed"}, {"symbols", symbolArray(request.value)}}));
     } else if (request.action == "unsubscribe") {
         unsubscribe(request.value);
+        sendControl(boost::json::serialize(boost::json::object{{"type", "unsubscribed"}, {"symbols", symbolArray(request.value)}}));
+    } else if (request.action == "ping") {
+        static const FrameWriter::Frame pongFrame = FrameWriter::text(R"({"type":"pong"})");
+        FrameWriter::send(connection_, pongFrame, FrameWriter::Lane::Control);
     } else {
-        ws_.async_write(boost::asio::buffer("Unknown action"), [](boost::system::error_code, std::size_t) {});
+        sendControl("Unknown action");
     }
 }
 
-void WebSocketSession::manageHeartbeat() {
-    const std::chrono::seconds heartbeatInterval(5);       // Send heartbeat every 5 sec
-    const std::chrono::seconds heartbeatTimeout(20);       // Disconnect if inactive for 20 sec
+void WebSocketSession::sendControl(std::string_view message) {
+    FrameWriter::send(connection_, FrameWriter::text(message), FrameWriter::Lane::Control);
+}
 
-    lastHeartbeatReceived = std::chrono::steady_clock::now();
+boost::json::array WebSocketSession::symbolArray(const std::vector<std::string>& symbols) {
+    boost::json::array array;
+    for (const auto& symbol : symbols) {
+        array.emplace_back(boost::json::string_view(symbol.data(), symbol.size()));
+    }
+    return array;
+}
 
-    while (true) {
-        {
-            std::unique_lock<std::mutex> lock(connection_->mutex);
+void WebSocketSession::scheduleHeartbeat() {
+    const std::chrono::seconds heartbeatInterval(5);       // Send heartbeat every 5 sec
+    const std::chrono::seconds heartbeatTimeout(20);       // Disconnect if inactive for 20 sec
 
-            // Wait for a new message or timeout check (whichever happens first)
-            heartbeatCV.wait_for(lock, heartbeatInterval, [&] {
-                return std::chrono::steady_clock::now() - lastHeartbeatReceived.load() < heartbeatTimeout;
-            });
+    // A timer on the io thread instead of a thread per connection, it is cancelled on disconnect
+    connection_->heartbeatTimer.expires_after(heartbeatInterval);
+    connection_->heartbeatTimer.async_wait([self = shared_from_this(), heartbeatTimeout](boost::system::error_code ec) {
+        if (ec) {
+            return;
         }
 
         // Check if last received message is too old
-        if (std::chrono::steady_clock::now() - lastHeartbeatReceived.load() >= heartbeatTimeout) {
+        if (std::chrono::steady_clock::now() - self->connection_->lastMessageAt >= heartbeatTimeout) {
             std::cerr << "Heartbeat timeout, closing connection.\n";
-            handleDisconnection(connection_);
+            handleDisconnection(self->connection_);
             return;
         }
-
-        // Send heartbeat
-        {
-            std::lock_guard<std::mutex> lock(connection_->mutex);
-            boost::system::error_code ec;
-            ws_.write(boost::asio::buffer(R"({"type":"heartbeat"})"), ec);
-            if (ec) {
-                std::cerr << "Error writing heartbeat: " << ec.message() << std::endl;
-                handleDisconnection(connection_);
-                return;
-            }
+        // A client that keeps sending but stops reading is just as gone
+        if (FrameWriter::stalled(self->connection_, heartbeatTimeout)) {
+            std::cerr << "Write timeout, closing connection.\n";
+            handleDisconnection(self->connection_);
+            return;
         }
-    }
+
+        // Send heartbeat, the frame is identical for every connection so it is encoded once
+        static const FrameWriter::Frame heartbeatFrame = FrameWriter::text(R"({"type":"heartbeat"})");
+        FrameWriter::send(self->connection_, heartbeatFrame, FrameWriter::Lane::Control);
+        self->scheduleHeartbeat();
+    });
 }
 
 
-void WebSocketSession::subscribe(const std::vector<std::string>& symbols) {
+void WebSocketSession::subscribe(const std::vector<std::string>& symbols, const SubscriptionView& view) {
+    auto& subscribed = connection_->symbols;
     for (const auto& symbol : symbols) {
-        subscribedSymbols_.insert(symbol);
+        if (std::find(subscribed.begin(), subscribed.end(), symbol) == subscribed.end()) {
+            subscribed.push_back(symbol);
+        }
     }
     std::cout << "Subscribed to symbols: ";
-    for (const auto& s : subscribedSymbols_) std::cout << s << " ";
+    for (const auto& s : subscribed) std::cout << s << " ";
     std::cout << std::endl;
 
     for(const auto& symbol: symbols){
-        auto connectionListOpt = symbolConnectionMap.find(symbol);
-        if(connectionListOpt) {
-            auto& connectionList = connectionListOpt.value();
-            bool connectionExists = false;
-            for(const auto& conn: connectionList){
-                if(conn->connId == connection_->connId){
-                    connectionExists = true;
-                    break;
+        /*
+         * Each connection sits in exactly one group per symbol. Subscribing again with a different
+         * view moves it, and connections asking for an identical view join the existing group.
+         */
+        auto groups = symbolConnectionMap.find(symbol).value_or(std::vector<SubscriberGroup>{});
+        bool joined = false;
+        for(auto& group: groups){
+            auto& conns = group.connections;
+            if(group.view->key() == view.key()){
+                if(std::none_of(conns.begin(), conns.end(), [&](const auto& conn){ return conn->connId == connection_->connId; })){
+                    conns.push_back(connection_);
                 }
+                joined = true;
+            } else {
+                conns.erase(std::remove_if(conns.begin(), conns.end(),
+                                           [&](const auto& conn){ return conn->connId == connection_->connId; }),
+                            conns.end());
             }
-            if(!connectionExists){
-                connectionList.push_back(connection_);
-                symbolConnectionMap.insert(symbol, connectionList);
-            }
-        } else {
-            symbolConnectionMap.insert(symbol, std::vector<std::shared_ptr<SocketConnection>>{connection_});
         }
-    }
-
-    auto symbolListOpt= connectionSymbolMap.find(connection_);
-    if(symbolListOpt){
-        auto &symbolList = symbolListOpt.value();
-        std::for_each(symbols.begin(), symbols.end(), [&](const std::string& symbol) {
-            symbolList.insert(symbol);
-        });
-        connectionSymbolMap.insert(connection_, symbolList);
-    } else {
-        connectionSymbolMap.insert(connection_, std::unordered_set<std::string>(symbols.begin(), symbols.end()));
+        groups.erase(std::remove_if(groups.begin(), groups.end(), [](const SubscriberGroup& group){ return group.connections.empty(); }),
+                     groups.end());
+        if(!joined){
+            groups.push_back(SubscriberGroup{std::make_shared<const SubscriptionView>(view), {connection_}});
+        }
+        symbolConnectionMap.insert(symbol, groups);
     }
 
     for(const auto& symbol: symbols){
@@ -173,81 +293,67 @@ void WebSocketSession::subscribe(const std::vector<std::string>& symbols) {
 
 
 void WebSocketSession::unsubscribe(const std::vector<std::string>& symbols) {
-    for (const auto& symbol : symbols) {
-        subscribedSymbols_.erase(symbol);
+    auto& subscribed = connection_->symbols;
+    subscribed.erase(std::remove_if(subscribed.begin(), subscribed.end(),
+                                    [&](const std::string& symbol) {
+                                        return std::find(symbols.begin(), symbols.end(), symbol) != symbols.end();
+                                    }),
+                     subscribed.end());
+    if (subscribed.empty()) {
+        // back to the inline storage if the list had spilled to the heap
+        subscribed.shrink_to_fit();
     }
     std::cout << "Unsubscribed from symbols.\n";
 
     for (const auto& symbol : symbols) {
-        auto connectionListOpt = symbolConnectionMap.find(symbol);
-        if (connectionListOpt) {
-            auto& connectionList = connectionListOpt.value();
-            auto it = std::remove_if(connectionList.begin(), connectionList.end(),
-                                     [&](const std::shared_ptr<SocketConnection>& conn) {
-                                         return conn->connId == connection_->connId;
-                                     });
-
-            if (it != connectionList.end()) {
-                connectionList.erase(it, connectionList.end());
-
-                if (connectionList.empty()) {
-                    symbolConnectionMap.remove(symbol);
-                    streamStatusMap.insert(symbol, false);
-                } else {
-                    symbolConnectionMap.insert(symbol, connectionList);
-                }
-            }
-        }
+        removeSubscriber(symbol, connection_->connId);
     }
+}
 
-    auto symbolListOpt = connectionSymbolMap.find(connection_);
-    if (symbolListOpt) {
-        auto& symbolList = symbolListOpt.value();
-
-        std::unordered_set<std::string> updatedSymbolList;
-        std::copy_if(symbolList.begin(), symbolList.end(),
-                     std::inserter(updatedSymbolList, updatedSymbolList.end()),
-                     [&](const std::string& symbol) {
-                         return std::find(symbols.begin(), symbols.end(), symbol) == symbols.end();
-                     });
-
-        if (updatedSymbolList.empty()) {
-            connectionSymbolMap.remove(connection_);
-        } else {
-            connectionSymbolMap.insert(connection_, updatedSymbolList);
-        }
+void WebSocketSession::handleDisconnection(std::shared_ptr<SocketConnection> connection) {
+    for (const auto &symbol: connection->symbols) {
+        removeSubscriber(symbol, connection->connId);
     }
-
+    connection->symbols.clear();
+    connection->symbols.shrink_to_fit();
+    connectionRegistry.remove(connection->connId);
+
+    // Stops the heartbeat and fails the pending read, which releases the last references to the connection
+    boost::system::error_code ec;
+    connection->heartbeatTimer.cancel();
+    connection->socket.close(ec);
 }
 
-void WebSocketSession::handleDisconnection(std::shared_ptr<SocketConnection> connection) {
-    auto symbolListOpt = connectionSymbolMap.find(connection);
-    if (symbolListOpt) {
-        auto &symbolList = symbolListOpt.value();
-
-        for (const auto &symbol: symbolList) {
-            auto connectionListOpt = symbolConnectionMap.find(symbol);
-            if (connectionListOpt) {
-                auto &connectionList = connectionListOpt.value();
-
-                auto it = std::find_if(connectionList.begin(), connectionList.end(),
-                                       [&](const std::shared_ptr<SocketConnection> &conn) {
-                                           return conn->connId == connection->connId;
-                                       });
-
-                if (it != connectionList.end()) {
-                    connectionList.erase(it);
-
-                    if (connectionList.empty()) {
-                        symbolConnectionMap.remove(symbol);
-                        streamStatusMap.insert(symbol, false);
-                    } else {
-                        symbolConnectionMap.insert(symbol, connectionList);
-                    }
-                }
-            }
-        }
+void WebSocketSession::disconnectAll() {
+    std::vector<std::shared_ptr<SocketConnection>> connections;
+    connectionRegistry.forEach([&](const std::string&, const std::shared_ptr<SocketConnection>& conn) {
+        connections.push_back(conn);
+    });
+    for (const auto& conn : connections) {
+        handleDisconnection(conn);
     }
-    connectionSymbolMap.remove(connection);
 }
 
+void WebSocketSession::removeSubscriber(const std::string& symbol, const std::string& connId) {
+    auto groupsOpt = symbolConnectionMap.find(symbol);
+    if (!groupsOpt) {
+        return;
+    }
+    auto& groups = groupsOpt.value();
+    for (auto& group : groups) {
+        auto& conns = group.connections;
+        conns.erase(std::remove_if(conns.begin(), conns.end(),
+                                   [&](const std::shared_ptr<SocketConnection>& conn) { return conn->connId == connId; }),
+                    conns.end());
+    }
+    groups.erase(std::remove_if(groups.begin(), groups.end(),
+                                [](const SubscriberGroup& group) { return group.connections.empty(); }),
+                 groups.end());
+
+    if (groups.empty()) {
+        symbolConnectionMap.remove(symbol);
+        streamStatusMap.insert(symbol, false);
+    } else {
+        symbolConnectionMap.insert(symbol, groups);
+    }
+}
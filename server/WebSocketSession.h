@@ -7,33 +7,52 @@
 
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
-#include <unordered_set>
 #include <string>
+#include <string_view>
+#include <boost/json.hpp>
 
 #include "../model/SocketConnection.h"
+#include "../model/SubscriptionView.h"
+#include "FrameReader.h"
 
+namespace http = boost::beast::http;
 namespace websocket = boost::beast::websocket;
 using tcp = boost::asio::ip::tcp;
 
 class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
 public:
-    explicit WebSocketSession(tcp::socket socket);
-    void start();
+    WebSocketSession(std::string connId, tcp::socket socket);
+    void start(http::request<http::string_body> req);
+
+    // Picks up an already upgraded client handed over by a previous process, without a new handshake
+    void resume(const std::vector<std::pair<std::string, SubscriptionView>>& subscriptions);
 
     static void handleDisconnection(std::shared_ptr<SocketConnection> conn);
+
+    // Disconnects every client, on shutdown while the io_context owning their sockets still exists
+    static void disconnectAll();
 private:
-    websocket::stream<tcp::socket> ws_;
-    std::unordered_set<std::string> subscribedSymbols_;
-    std::shared_ptr<SocketConnection> connection_;
+    // Upper bound on a client message, and the read buffer size kept around between messages
+    static constexpr size_t maxMessageBytes = 16 * 1024;
+    static constexpr size_t idleBufferBytes = 512;
 
-    std::atomic<std::chrono::steady_clock::time_point> lastHeartbeatReceived;
-    std::condition_variable heartbeatCV;
+    std::shared_ptr<SocketConnection> connection_;
 
-    void readMessage();
+    void onOpen();
+    void readMessage(size_t minBytes = idleBufferBytes);
+    // Handles every complete frame in the read buffer, returns false once the connection is closing
+    bool readFrames(size_t& bytesNeeded);
+    bool handleFrame(const FrameReader::Frame& frame);
+    void close(uint16_t code);
     void handleMessage(const std::string& message);
-    void manageHeartbeat();
-    void subscribe(const std::vector<std::string>& symbols);
+    // Replies, acks and heartbeats jump ahead of queued market data
+    void sendControl(std::string_view message);
+    static boost::json::array symbolArray(const std::vector<std::string>& symbols);
+    void scheduleHeartbeat();
+    void subscribe(const std::vector<std::string>& symbols, const SubscriptionView& view);
     void unsubscribe(const std::vector<std::string>& symbols);
+
+    static void removeSubscriber(const std::string& symbol, const std::string& connId);
 };
 
 #endif // WEBSOCKETSESSION_H
@@ -18,6 +18,10 @@ public:
     bool remove(const K &key);
     std::optional<V> find(const K &key) const;
 
+    // Visits every entry under shared locks, fn must not call back into this map
+    template<typename Fn>
+    void forEach(Fn fn) const;
+
 private:
     std::vector<std::list<std::pair<K, V>>> buckets;
     mutable std::vector<std::shared_mutex> locks;
@@ -43,21 +47,27 @@ size_t ConcurrentHashMap<K, V>::hash(const K &key) const {
 
 template<typename K, typename V>
 void ConcurrentHashMap<K, V>::insert(const K &key, const V &value) {
-    size_t index = hash(key);
-    std::unique_lock<std::shared_mutex> lock(locks[index]);
-    auto &bucket = buckets[index];
-    for(auto &pair: bucket){
-        if(pair.first == key){
-            pair.second = value;
-            return;
+    bool grow;
+    {
+        // to prevent access during resizing
+        std::shared_lock<std::shared_mutex> global_lock(global_mutex);
+
+        size_t index = hash(key);
+        std::unique_lock<std::shared_mutex> lock(locks[index]);
+        auto &bucket = buckets[index];
+        for(auto &pair: bucket){
+            if(pair.first == key){
+                pair.second = value;
+                return;
+            }
         }
+        bucket.emplace_back(key, value);
+        size.fetch_add(1, std::memory_order_relaxed);
+        grow = size.load(std::memory_order_relaxed) >= load_factor * buckets.size();
     }
-    bucket.emplace_back(key, value);
-    size.fetch_add(1, std::memory_order_relaxed);
 
-    if(size.load(std::memory_order_relaxed) >= load_factor * buckets.size()){
-        lock.unlock();
-        std::unique_lock<std::shared_mutex> global_lock(global_mutex);
+    // rehash takes the global lock itself, so every lock is released first
+    if(grow){
         rehash();
     }
 }
@@ -96,9 +106,27 @@ bool ConcurrentHashMap<K, V>::remove(const K &key) {
     return false;
 }
 
+template<typename K, typename V>
+template<typename Fn>
+void ConcurrentHashMap<K, V>::forEach(Fn fn) const {
+    // to prevent access during resizing
+    std::shared_lock<std::shared_mutex> global_lock(global_mutex);
+
+    for(size_t index = 0; index < buckets.size(); ++index){
+        std::shared_lock<std::shared_mutex> lock(locks[index]);
+        for(const auto& pair: buckets[index]){
+            fn(pair.first, pair.second);
+        }
+    }
+}
+
 template<typename K, typename V>
 void ConcurrentHashMap<K, V>::rehash() {
     std::unique_lock<std::shared_mutex> global_lock(global_mutex);
+    // another insert may have grown the map while this one waited for the lock
+    if(size.load(std::memory_order_relaxed) < load_factor * buckets.size()){
+        return;
+    }
 
     size_t new_bucket_count = buckets.size() * 2;
     std::vector<std::list<std::pair<K, V>>> new_buckets(new_bucket_count);
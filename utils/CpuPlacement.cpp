@@ -0,0 +1,191 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "CpuPlacement.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+CpuPlacement::Placement CpuPlacement::io;
+CpuPlacement::Placement CpuPlacement::ingest;
+std::vector<int> CpuPlacement::originalCpus;
+std::vector<std::pair<int, std::vector<int>>> CpuPlacement::nodes;
+
+void CpuPlacement::configure(const std::string& ioCpus, const std::string& ingestCpus) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) originalCpus.push_back(cpu);
+        }
+    }
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            continue;
+        }
+        std::ifstream cpulist(entry.path() / "cpulist");
+        std::string list;
+        std::getline(cpulist, list);
+        nodes.emplace_back(std::stoi(name.substr(4)), parseCpuList(list));
+    }
+    std::sort(nodes.begin(), nodes.end());
+
+    for (auto [placement, list] : {std::pair{&io, &ioCpus}, std::pair{&ingest, &ingestCpus}}) {
+        for (int cpu : parseCpuList(*list)) {
+            // cores outside the cpuset the process was started with cannot be used
+            if (std::find(originalCpus.begin(), originalCpus.end(), cpu) != originalCpus.end()) {
+                placement->cpus.push_back(cpu);
+            } else {
+                std::cerr << "Ignoring cpu " << cpu << ", it is not available to this process" << std::endl;
+            }
+        }
+        placement->node = nodeOf(placement->cpus);
+    }
+#else
+    if (!ioCpus.empty() || !ingestCpus.empty()) {
+        std::cerr << "CPU placement is only supported on Linux, ignoring it" << std::endl;
+    }
+#endif
+}
+
+void CpuPlacement::pinCurrentThread(Role role) {
+#ifdef __linux__
+    if (io.cpus.empty() && ingest.cpus.empty()) {
+        return;
+    }
+
+    // An unpinned role goes back to the original cpus, threads otherwise inherit their creator's pinning
+    const auto& placement = placementOf(role);
+    const auto& cpus = placement.cpus.empty() ? originalCpus : placement.cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0) {
+        std::cerr << "Failed to pin thread to cpus " << formatCpuList(cpus) << ": error " << rc << std::endl;
+    }
+
+    /*
+     * Prefer (not bind) the node of the pinned cores, so what this thread allocates from here on stays
+     * local but can still spill over when the node runs out of memory.
+     */
+    long rc;
+    if (placement.node >= 0) {
+        constexpr size_t bitsPerWord = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask(placement.node / bitsPerWord + 1, 0);
+        mask[placement.node / bitsPerWord] |= 1UL << (placement.node % bitsPerWord);
+        rc = syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), mask.size() * bitsPerWord + 1);
+    } else {
+        rc = syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+    }
+    if (rc != 0) {
+        std::cerr << "Failed to set memory policy for node " << placement.node << std::endl;
+    }
+#endif
+}
+
+void CpuPlacement::reportTopology() {
+#ifdef __linux__
+    if (nodes.empty()) {
+        std::cout << "CPU topology: NUMA information unavailable, " << originalCpus.size() << " usable cpu(s)" << std::endl;
+    } else {
+        std::cout << "CPU topology: " << nodes.size() << " NUMA node(s), " << originalCpus.size() << " usable cpu(s)" << std::endl;
+        for (const auto& [node, cpus] : nodes) {
+            std::cout << "  node " << node << ": cpus " << formatCpuList(cpus) << std::endl;
+        }
+    }
+    std::cout << "Thread placement: " << describe("io", io) << ", " << describe("ingest", ingest) << std::endl;
+
+    // Fan-out runs on the ingest threads but every connection lives on the io thread's node
+    if (io.node >= 0 && ingest.node >= 0 && io.node != ingest.node) {
+        std::cerr << "Warning: io and ingest threads are on different NUMA nodes, "
+                     "fan-out will write every connection's frame queue across sockets" << std::endl;
+    }
+#endif
+}
+
+const CpuPlacement::Placement& CpuPlacement::placementOf(Role role) {
+    return role == Role::Io ? io : ingest;
+}
+
+std::vector<int> CpuPlacement::parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        try {
+            auto dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid cpu range '" << range << "' in '" << list << "'" << std::endl;
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string CpuPlacement::formatCpuList(const std::vector<int>& cpus) {
+    std::string list;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!list.empty()) list += ',';
+        list += std::to_string(cpus[i]);
+        if (j > i) list += '-' + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return list;
+}
+
+int CpuPlacement::nodeOf(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return -1;
+    }
+    for (const auto& [node, nodeCpus] : nodes) {
+        if (std::all_of(cpus.begin(), cpus.end(), [&](int cpu) {
+                return std::binary_search(nodeCpus.begin(), nodeCpus.end(), cpu);
+            })) {
+            return node;
+        }
+    }
+    return -1;
+}
+
+std::string CpuPlacement::describe(const char* name, const Placement& placement) {
+    std::string text = std::string(name) + " -> ";
+    if (placement.cpus.empty()) {
+        return text + "unpinned";
+    }
+    text += "cpus " + formatCpuList(placement.cpus);
+    if (placement.node >= 0) {
+        text += " (node " + std::to_string(placement.node) + ")";
+    } else if (!nodes.empty()) {
+        text += " (spans nodes, default memory policy)";
+    }
+    return text;
+}
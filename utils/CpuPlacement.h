@@ -0,0 +1,46 @@
+//
+// Created by Satyam Saurabh on 19/10/26.
+//
+
+#ifndef SOCKETSERVICE_CPUPLACEMENT_H
+#define SOCKETSERVICE_CPUPLACEMENT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Pins the service's threads to configured cores and keeps their allocations on the matching NUMA node.
+ *  - Io: the thread running the io_context. It owns every connection, so SocketConnection, its
+ *    websocket stream, read buffer and timer are allocated there.
+ *  - Ingest: the Redis stream readers (and the replayer), which also do the fan-out to connections.
+ * A role without cores configured keeps the process' original affinity and memory policy.
+ */
+class CpuPlacement {
+public:
+    enum class Role { Io, Ingest };
+
+    // cpu lists in the kernel's format, e.g. "0-3,8"; empty leaves the role unpinned
+    static void configure(const std::string& ioCpus, const std::string& ingestCpus);
+    static void pinCurrentThread(Role role);
+    static void reportTopology();
+
+private:
+    struct Placement {
+        std::vector<int> cpus;
+        int node = -1;   // -1 if unpinned or the cores span several nodes
+    };
+
+    static Placement io;
+    static Placement ingest;
+    static std::vector<int> originalCpus;
+    static std::vector<std::pair<int, std::vector<int>>> nodes;   // node id -> its cpus
+
+    static const Placement& placementOf(Role role);
+    static std::vector<int> parseCpuList(const std::string& list);
+    static std::string formatCpuList(const std::vector<int>& cpus);
+    static int nodeOf(const std::vector<int>& cpus);
+    static std::string describe(const char* name, const Placement& placement);
+};
+
+#endif //SOCKETSERVICE_CPUPLACEMENT_H
@@ -4,6 +4,7 @@
 
 #include "GlobalMaps.h"
 
-ConcurrentHashMap<std::string, std::vector<std::shared_ptr<SocketConnection>>> symbolConnectionMap(2000);
-ConcurrentHashMap<std::shared_ptr<SocketConnection>, std::unordered_set<std::string>> connectionSymbolMap(10'000);
-ConcurrentHashMap<std::string, bool> streamStatusMap(2000);
\ No newline at end of file
+ConcurrentHashMap<std::string, std::vector<SubscriberGroup>> symbolConnectionMap(2000);
+ConcurrentHashMap<std::string, bool> streamStatusMap(2000);
+ConcurrentHashMap<std::string, std::shared_ptr<SocketConnection>> connectionRegistry(10'000);
+ConcurrentHashMap<std::string, std::string> streamOffsetMap(2000);
@@ -5,23 +5,27 @@
 #ifndef SOCKETSERVICE_GLOBALMAPS_H
 #define SOCKETSERVICE_GLOBALMAPS_H
 
-#include <unordered_set>
-
 #include "ConcurrentHashMap.h"
 #include "../model/SocketConnection.h"
+#include "../model/SubscriptionView.h"
 
 /*
  * To do an efficient connection management, these maps are created:
- * 1. symbolConnectionMap: key -> symbol | value -> list of connection object
+ * 1. symbolConnectionMap: key -> symbol | value -> connections grouped by subscription view
  *    This map is used while broadcasting a symbol tick to all connections subscribed to it.
- * 2. connectionSymbolMap: key -> connection object | value -> list of symbol
- *    This map is used for storing list of symbols for a connection.
+ *    The symbols a connection is subscribed to are kept on the connection itself (SocketConnection::symbols).
+ * 2. connectionRegistry: key -> connection id | value -> connection object
+ *    This map holds every live connection, subscribed or not, so they can be handed off on restart.
+ * 3. streamOffsetMap: key -> symbol | value -> id of the last stream entry broadcast to clients
+ *    This map lets a successor process resume each stream where this one stopped.
  */
 
-extern ConcurrentHashMap<std::string, std::vector<std::shared_ptr<SocketConnection>>> symbolConnectionMap;
-
-extern ConcurrentHashMap<std::shared_ptr<SocketConnection>, std::unordered_set<std::string>> connectionSymbolMap;
+extern ConcurrentHashMap<std::string, std::vector<SubscriberGroup>> symbolConnectionMap;
 
 extern ConcurrentHashMap<std::string, bool> streamStatusMap;
 
+extern ConcurrentHashMap<std::string, std::shared_ptr<SocketConnection>> connectionRegistry;
+
+extern ConcurrentHashMap<std::string, std::string> streamOffsetMap;
+
 #endif //SOCKETSERVICE_GLOBALMAPS_H